@@ -27,7 +27,8 @@ public class EmotionEngine : ModuleRules
 			{
 				"Core",
 				"GameplayTags",
-                "Engine"
+                "Engine",
+				"DeveloperSettings"
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -0,0 +1,69 @@
+#include "EmotionArchetype.h"
+#include "EmotionData.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(EmotionArchetype)
+
+UEmotionArchetype::UEmotionArchetype()
+    : InitialVACoordinate(FVector2D::ZeroVector)
+    , InfluenceRadius(0.3f)
+    , EmotionalSusceptibility(1.0f)
+    , SpringStiffness(2.0f)
+    , DampingFactor(0.5f)
+{}
+
+const FEmotionStateData* UEmotionArchetype::GetBaselineState(UEmotionLibrary* Library)
+{
+    if (!Library)
+    {
+        return nullptr;
+    }
+
+    TUniquePtr<FEmotionStateData>& BaselineState = BaselineStates.FindOrAdd(Library);
+    if (!BaselineState)
+    {
+        BaselineState = MakeUnique<FEmotionStateData>();
+        BuildBaselineState(*BaselineState, Library);
+        BaselineLibraries.Add(Library);
+    }
+    return BaselineState.Get();
+}
+
+SIZE_T UEmotionArchetype::GetBaselineAllocatedSize() const
+{
+    SIZE_T Size = BaselineStates.GetAllocatedSize() + BaselineLibraries.GetAllocatedSize();
+    for (const TPair<TObjectKey<UEmotionLibrary>, TUniquePtr<FEmotionStateData>>& Pair : BaselineStates)
+    {
+        Size += sizeof(FEmotionStateData) + Pair.Value->GetAllocatedSize();
+    }
+    return Size;
+}
+
+void UEmotionArchetype::BuildBaselineState(FEmotionStateData& BaselineState, UEmotionLibrary* Library) const
+{
+    // Built in place, agents at the baseline keep pointing at it across rebuilds
+    BaselineState.Initialize(Library);
+    BaselineState.InfluenceRadius = InfluenceRadius;
+    BaselineState.SpringStiffness = SpringStiffness;
+    BaselineState.DampingFactor = DampingFactor;
+
+    // The baseline has no world, its decay time is restarted when an agent copies it
+    BaselineState.BeginBatch(0.0f);
+    for (const TPair<FGameplayTag, float>& InitialEmotion : InitialEmotions)
+    {
+        BaselineState.SetIntensity(InitialEmotion.Key, InitialEmotion.Value, 0.0f);
+    }
+    BaselineState.EndBatch();
+    BaselineState.SetVACoordinate(InitialVACoordinate);
+}
+
+#if WITH_EDITOR
+void UEmotionArchetype::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+
+    for (const TPair<TObjectKey<UEmotionLibrary>, TUniquePtr<FEmotionStateData>>& Pair : BaselineStates)
+    {
+        BuildBaselineState(*Pair.Value, Pair.Value->GetEmotionLibrary());
+    }
+}
+#endif
@@ -1,4 +1,6 @@
 #include "EmotionComponent.h"
+#include "EmotionEngine.h"
+#include "EmotionArchetype.h"
 #include "EmotionSubsystem.h"
 #include "EmotionSystemLibrary.h"
 #include "Kismet/GameplayStatics.h"
@@ -11,12 +13,15 @@ UEmotionComponent::UEmotionComponent(const FObjectInitializer& ObjectInitializer
 {
 	// Set this component to be initialized when the game starts, and to be ticked every frame
 	PrimaryComponentTick.bCanEverTick = true;
-	EmotionState = CreateDefaultSubobject<UEmotionState>(TEXT("EmotionState"));
 	
 	// Default values
 	EmotionalSusceptibility = 1.0f;
 	SpringStiffness = 2.0f;
 	DampingFactor = 0.5f;
+	bUsePooledState = false;
+	bDeferChangeNotifications = true;
+	IntensityChangeThreshold = 1.0f;
+	VAChangeThreshold = 0.01f;
 }
 
 // Called when the game starts
@@ -35,6 +40,12 @@ void UEmotionComponent::BeginPlay()
 			EmotionSubsystem->RegisterEmotionComponent(this);
 		}
 	}
+	
+	// Pooled states are ticked by the subsystem, a shared baseline is never ticked, a streaming library enables it once loaded
+	if (IsUsingPooledState() || IsAtArchetypeBaseline() || IsWaitingForEmotionLibrary())
+	{
+		SetComponentTickEnabled(false);
+	}
 }
 
 // Called every frame
@@ -42,18 +53,150 @@ void UEmotionComponent::TickComponent(float DeltaTime, ELevelTick TickType, FAct
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 	
-	// Update the emotion state
-	if (EmotionState)
+	// Update the emotion state, pooled states are updated by the subsystem
+	if (EmotionState && !IsUsingPooledState())
 	{
+		SyncStateSettings();
 		EmotionState->Tick(DeltaTime);
 		
-		// Get the previous VA coordinate for change detection
-		FVector2D PreviousVA = EmotionState->VACoordinate;
-		
-		// If VA coordinate changed significantly, broadcast the change
-		if (!PreviousVA.Equals(EmotionState->VACoordinate, 0.01f))
+		// Report everything that changed since listeners were last notified, including this update
+		DispatchChangeNotifications();
+	}
+}
+
+void UEmotionComponent::SyncStateSettings()
+{
+	// The shared baseline keeps the archetype's settings
+	if (IsAtArchetypeBaseline())
+	{
+		return;
+	}
+	
+	// Spring settings are editable at runtime, keep the state in sync
+	if (FEmotionStateData* StateData = GetStateData())
+	{
+		StateData->SpringStiffness = SpringStiffness;
+		StateData->DampingFactor = DampingFactor;
+	}
+}
+
+FEmotionStateData* UEmotionComponent::GetStateData()
+{
+	// Writing to the shared baseline would change every agent of the archetype
+	if (IsAtArchetypeBaseline())
+	{
+		MaterializeArchetypeState();
+	}
+	
+	return const_cast<FEmotionStateData*>(static_cast<const UEmotionComponent*>(this)->GetStateData());
+}
+
+const FEmotionStateData* UEmotionComponent::GetStateData() const
+{
+	if (IsUsingPooledState())
+	{
+		const UEmotionSubsystem* EmotionSubsystem = StatePoolOwner.Get();
+		return EmotionSubsystem ? EmotionSubsystem->GetStatePool().Get(PooledStateHandle) : nullptr;
+	}
+	
+	if (ArchetypeBaseline)
+	{
+		return ArchetypeBaseline;
+	}
+	
+	return EmotionState ? EmotionState->GetStateData() : nullptr;
+}
+
+UEmotionState* UEmotionComponent::GetEmotionState()
+{
+	InitializeEmotionState();
+	
+	// The view needs a state of its own to point at
+	if (IsAtArchetypeBaseline())
+	{
+		MaterializeArchetypeState();
+	}
+	
+	// Pooled states get a view object the first time Blueprint asks for one
+	if (!EmotionState && IsUsingPooledState())
+	{
+		EmotionState = NewObject<UEmotionState>(this, TEXT("EmotionState"));
+		EmotionState->BindToPooledState(StatePoolOwner.Get(), PooledStateHandle);
+	}
+	
+	return EmotionState;
+}
+
+float UEmotionComponent::GetStateTime() const
+{
+	const UWorld* World = GetWorld();
+	return World ? World->GetTimeSeconds() : 0.0f;
+}
+
+void UEmotionComponent::DispatchChangeNotifications()
+{
+	const FEmotionStateData* StateData = AsConst(*this).GetStateData();
+	if (!StateData)
+	{
+		return;
+	}
+	
+	// Read before broadcasting, listeners may allocate pooled states and move this one
+	const FVector2D CurrentVA = StateData->GetVACoordinate();
+	
+	TArray<FEmotionChange> Changes;
+	
+	// Emotions that entered, or drifted past the threshold since they were last reported
+	StateData->ForEachActiveEmotion([this, &Changes](const FGameplayTag& EmotionTag, float Intensity)
+	{
+		const float* NotifiedIntensity = LastNotifiedIntensities.Find(EmotionTag);
+		if (NotifiedIntensity)
+		{
+			if (FMath::Abs(Intensity - *NotifiedIntensity) >= IntensityChangeThreshold)
+			{
+				Changes.Emplace(EmotionTag, *NotifiedIntensity, Intensity);
+			}
+		}
+		else if (Intensity > 0.0f)
+		{
+			Changes.Emplace(EmotionTag, 0.0f, Intensity);
+		}
+	});
+	
+	// Emotions listeners know about that have left the state
+	for (const TPair<FGameplayTag, float>& Notified : LastNotifiedIntensities)
+	{
+		if (StateData->GetIntensity(Notified.Key) <= 0.0f)
+		{
+			Changes.Emplace(Notified.Key, Notified.Value, 0.0f);
+		}
+	}
+	
+	if (Changes.Num() > 0)
+	{
+		UpdateNotifiedIntensities(Changes);
+		BroadcastEmotionsChanged(Changes);
+	}
+	
+	// If VA coordinate changed significantly since the last report, broadcast the change
+	if (!LastNotifiedVA.Equals(CurrentVA, VAChangeThreshold))
+	{
+		LastNotifiedVA = CurrentVA;
+		BroadcastVACoordinateChanged(CurrentVA);
+	}
+}
+
+void UEmotionComponent::UpdateNotifiedIntensities(const TArray<FEmotionChange>& Changes)
+{
+	for (const FEmotionChange& Change : Changes)
+	{
+		if (Change.NewIntensity > 0.0f)
+		{
+			LastNotifiedIntensities.Add(Change.EmotionTag, Change.NewIntensity);
+		}
+		else
 		{
-			BroadcastVACoordinateChanged(EmotionState->VACoordinate);
+			LastNotifiedIntensities.Remove(Change.EmotionTag);
 		}
 	}
 }
@@ -69,91 +212,323 @@ void UEmotionComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 		}
 	}
 	
+	ReleasePooledState();
+	
+	// Nothing to replay the buffered changes into anymore
+	if (LibraryLoadHandle.IsValid())
+	{
+		LibraryLoadHandle->CancelHandle();
+		LibraryLoadHandle.Reset();
+	}
+	PendingStimuli.Empty();
+	PendingVACoordinate.Reset();
+	
 	Super::EndPlay(EndPlayReason);
 }
 
-void UEmotionComponent::AddEmotion(const FGameplayTag& EmotionTag, float Intensity)
+void UEmotionComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
 {
-	// Ensure the emotion state is initialized
-	InitializeEmotionState();
+	ReleasePooledState();
+	
+	Super::OnComponentDestroyed(bDestroyingHierarchy);
+}
+
+void UEmotionComponent::ReleaseForActorPool()
+{
+	if (UWorld* World = GetWorld())
+	{
+		if (UEmotionSubsystem* EmotionSubsystem = World->GetSubsystem<UEmotionSubsystem>())
+		{
+			EmotionSubsystem->UnregisterEmotionComponent(this);
+		}
+	}
 	
-	// Store previous intensity for change detection
-	float PreviousIntensity = EmotionState->GetIntensity(EmotionTag);
+	// An open batch and changes waiting for the library belong to the previous life of the actor
+	BatchDepth = 0;
+	BatchBaseline.Reset();
+	PendingStimuli.Reset();
+	PendingVACoordinate.Reset();
 	
-	// Add the emotion to the state
-	EmotionState->AddEmotion(EmotionTag, Intensity);
+	// A load finishing while the actor is parked would initialize it and replay into it, reuse requests the library again
+	if (LibraryLoadHandle.IsValid())
+	{
+		LibraryLoadHandle->CancelHandle();
+		LibraryLoadHandle.Reset();
+	}
 	
-	// Notify listeners if intensity changed
-	if (!FMath::IsNearlyEqual(PreviousIntensity, EmotionState->GetIntensity(EmotionTag)))
+	if (IsUsingPooledState())
 	{
-		BroadcastEmotionChanged(EmotionTag, EmotionState->GetIntensity(EmotionTag));
+		ReleasePooledState();
 	}
+	else
+	{
+		ArchetypeBaseline = nullptr;
+		StatePoolOwner.Reset();
+		
+		// The library is cleared too, so the next initialization starts over with the current configuration
+		if (FEmotionStateData* StateData = EmotionState ? EmotionState->GetStateData() : nullptr)
+		{
+			StateData->Reset();
+		}
+	}
+	
+	LastNotifiedIntensities.Reset();
+	LastNotifiedVA = FVector2D::ZeroVector;
+	
+	SetComponentTickEnabled(false);
 }
 
-void UEmotionComponent::RemoveEmotion(const FGameplayTag& EmotionTag)
+void UEmotionComponent::ReuseFromActorPool()
 {
-	// Ensure the emotion state is initialized
 	InitializeEmotionState();
 	
-	// Store previous intensity for change detection
-	float PreviousIntensity = EmotionState->GetIntensity(EmotionTag);
+	// A Blueprint view of the released pooled state follows the new slot
+	if (EmotionState && EmotionState->IsPooledView())
+	{
+		if (IsAtArchetypeBaseline())
+		{
+			MaterializeArchetypeState();
+		}
+		EmotionState->BindToPooledState(StatePoolOwner.Get(), PooledStateHandle);
+	}
+	
+	if (UWorld* World = GetWorld())
+	{
+		if (UEmotionSubsystem* EmotionSubsystem = World->GetSubsystem<UEmotionSubsystem>())
+		{
+			EmotionSubsystem->RegisterEmotionComponent(this);
+		}
+	}
+	
+	// Same tick setup as BeginPlay
+	SetComponentTickEnabled(!IsUsingPooledState() && !IsAtArchetypeBaseline() && !IsWaitingForEmotionLibrary());
+}
+
+void UEmotionComponent::ReleasePooledState()
+{
+	ArchetypeBaseline = nullptr;
 	
-	// Only broadcast if the emotion actually existed
-	bool bShouldBroadcast = (PreviousIntensity > 0.0f);
+	if (!IsUsingPooledState())
+	{
+		return;
+	}
 	
-	// Remove the emotion from the state
-	EmotionState->RemoveEmotion(EmotionTag);
+	if (UEmotionSubsystem* EmotionSubsystem = StatePoolOwner.Get())
+	{
+		EmotionSubsystem->ReleasePooledState(this, PooledStateHandle);
+	}
+	PooledStateHandle.Invalidate();
+	StatePoolOwner.Reset();
+}
+
+void UEmotionComponent::AddEmotion(const FGameplayTag& EmotionTag, float Intensity)
+{
+	if (BufferWhileLibraryLoads(EEmotionDeltaOperation::Add, EmotionTag, Intensity))
+	{
+		return;
+	}
+	
+	// Single changes are a batch of one, listeners are notified on commit if the intensity changed
+	BeginEmotionBatch();
+	RecordBatchBaseline(EmotionTag);
+	
+	// Add the emotion to the state
+	if (FEmotionStateData* StateData = GetStateData())
+	{
+		StateData->AddEmotion(EmotionTag, Intensity, GetStateTime());
+	}
+	
+	CommitEmotionBatch();
+}
+
+void UEmotionComponent::RemoveEmotion(const FGameplayTag& EmotionTag)
+{
+	if (BufferWhileLibraryLoads(EEmotionDeltaOperation::Remove, EmotionTag, 0.0f))
+	{
+		return;
+	}
+	
+	BeginEmotionBatch();
+	RecordBatchBaseline(EmotionTag);
 	
-	// Notify listeners if the emotion was removed
-	if (bShouldBroadcast)
+	// Remove the emotion from the state
+	if (FEmotionStateData* StateData = GetStateData())
 	{
-		BroadcastEmotionChanged(EmotionTag, 0.0f);
+		StateData->RemoveEmotion(EmotionTag);
 	}
+	
+	CommitEmotionBatch();
 }
 
 void UEmotionComponent::SetEmotionIntensity(const FGameplayTag& EmotionTag, float Intensity)
+{
+	if (BufferWhileLibraryLoads(EEmotionDeltaOperation::Set, EmotionTag, Intensity))
+	{
+		return;
+	}
+	
+	BeginEmotionBatch();
+	RecordBatchBaseline(EmotionTag);
+	
+	// Set the intensity in the emotion state
+	if (FEmotionStateData* StateData = GetStateData())
+	{
+		StateData->SetIntensity(EmotionTag, Intensity, GetStateTime());
+	}
+	
+	CommitEmotionBatch();
+}
+
+void UEmotionComponent::BeginEmotionBatch()
 {
 	// Ensure the emotion state is initialized
 	InitializeEmotionState();
 	
-	// Store previous intensity for change detection
-	float PreviousIntensity = EmotionState->GetIntensity(EmotionTag);
+	if (BatchDepth++ == 0)
+	{
+		if (FEmotionStateData* StateData = GetStateData())
+		{
+			StateData->BeginBatch(GetStateTime());
+		}
+	}
+}
+
+void UEmotionComponent::CommitEmotionBatch()
+{
+	if (BatchDepth == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UEmotionComponent::CommitEmotionBatch - No batch in progress on %s"), *GetOwnerName());
+		return;
+	}
+	
+	// Only the outermost commit applies the batch
+	if (--BatchDepth > 0)
+	{
+		return;
+	}
 	
-	// Set the intensity in the emotion state
-	EmotionState->SetIntensity(EmotionTag, Intensity);
+	// Rebuild the derived state once for the whole batch
+	FEmotionStateData* StateData = GetStateData();
+	if (StateData)
+	{
+		StateData->EndBatch();
+	}
+	
+	// Deferred changes are reported by the per-frame notification stage
+	if (bDeferChangeNotifications || !StateData)
+	{
+		BatchBaseline.Reset();
+		return;
+	}
+	
+	// Collect the net change of every emotion touched by the batch
+	TArray<FEmotionChange> Changes;
+	for (const TPair<FGameplayTag, float>& Baseline : BatchBaseline)
+	{
+		const float NewIntensity = StateData->GetIntensity(Baseline.Key);
+		if (!FMath::IsNearlyEqual(Baseline.Value, NewIntensity))
+		{
+			Changes.Emplace(Baseline.Key, Baseline.Value, NewIntensity);
+		}
+	}
+	BatchBaseline.Reset();
+	
+	if (Changes.Num() > 0)
+	{
+		UpdateNotifiedIntensities(Changes);
+		BroadcastEmotionsChanged(Changes);
+	}
+}
+
+void UEmotionComponent::ApplyEmotionDeltas(const TArray<FEmotionDelta>& Deltas)
+{
+	BeginEmotionBatch();
 	
-	// Notify listeners if intensity changed
-	if (!FMath::IsNearlyEqual(PreviousIntensity, EmotionState->GetIntensity(EmotionTag)))
+	for (const FEmotionDelta& Delta : Deltas)
+	{
+		switch (Delta.Operation)
+		{
+		case EEmotionDeltaOperation::Add:
+			AddEmotion(Delta.EmotionTag, Delta.Intensity);
+			break;
+		case EEmotionDeltaOperation::Set:
+			SetEmotionIntensity(Delta.EmotionTag, Delta.Intensity);
+			break;
+		case EEmotionDeltaOperation::Remove:
+			RemoveEmotion(Delta.EmotionTag);
+			break;
+		}
+	}
+	
+	CommitEmotionBatch();
+}
+
+void UEmotionComponent::RecordBatchBaseline(const FGameplayTag& EmotionTag)
+{
+	// The per-frame stage compares against the last notified values instead
+	if (!bDeferChangeNotifications && !BatchBaseline.Contains(EmotionTag))
 	{
-		BroadcastEmotionChanged(EmotionTag, EmotionState->GetIntensity(EmotionTag));
+		BatchBaseline.Add(EmotionTag, GetEmotionIntensity(EmotionTag));
 	}
 }
 
 float UEmotionComponent::GetEmotionIntensity(const FGameplayTag& EmotionTag) const
 {
-	return EmotionState ? EmotionState->GetIntensity(EmotionTag) : 0.0f;
+	const FEmotionStateData* StateData = GetStateData();
+	return StateData ? StateData->GetIntensity(EmotionTag) : 0.0f;
 }
 
 bool UEmotionComponent::HasEmotionTag(const FGameplayTag& EmotionTag) const
 {
-	return EmotionState ? EmotionState->EmotionTags.HasTag(EmotionTag) : false;
+	const FEmotionStateData* StateData = GetStateData();
+	return StateData ? StateData->HasEmotionTag(EmotionTag) : false;
+}
+
+bool UEmotionComponent::HasAnyEmotionTags(const FGameplayTagContainer& EmotionTags) const
+{
+	return MatchesAnyEmotionTags(FEmotionTagQueryMask(EmotionTags));
+}
+
+bool UEmotionComponent::HasAllEmotionTags(const FGameplayTagContainer& EmotionTags) const
+{
+	return MatchesAllEmotionTags(FEmotionTagQueryMask(EmotionTags));
+}
+
+bool UEmotionComponent::MatchesAnyEmotionTags(const FEmotionTagQueryMask& Query) const
+{
+	const FEmotionStateData* StateData = GetStateData();
+	return StateData ? StateData->MatchesAnyEmotionTags(Query) : false;
+}
+
+bool UEmotionComponent::MatchesAllEmotionTags(const FEmotionTagQueryMask& Query) const
+{
+	const FEmotionStateData* StateData = GetStateData();
+	return StateData ? StateData->MatchesAllEmotionTags(Query) : false;
 }
 
 FGameplayTagContainer UEmotionComponent::GetAllEmotionTags() const
 {
-	return EmotionState ? EmotionState->EmotionTags : FGameplayTagContainer();
+	const FEmotionStateData* StateData = GetStateData();
+	return StateData ? StateData->GetEmotionTags() : FGameplayTagContainer();
+}
+
+uint32 UEmotionComponent::GetEmotionTagSetId() const
+{
+	const FEmotionStateData* StateData = GetStateData();
+	return StateData ? StateData->GetEmotionTagSetId() : FEmotionTagSetTable::EmptySetId;
 }
 
 TArray<FActiveEmotion> UEmotionComponent::GetActiveEmotions() const
 {
-	return EmotionState ? EmotionState->GetActiveEmotions() : TArray<FActiveEmotion>();
+	const FEmotionStateData* StateData = GetStateData();
+	return StateData ? StateData->GetActiveEmotions() : TArray<FActiveEmotion>();
 }
 
 void UEmotionComponent::GetDominantEmotion(FGameplayTag& OutEmotionTag, float& OutIntensity) const
 {
-	if (EmotionState)
+	if (const FEmotionStateData* StateData = GetStateData())
 	{
-		EmotionState->GetDominantEmotion(OutEmotionTag, OutIntensity);
+		StateData->GetDominantEmotion(OutEmotionTag, OutIntensity);
 	}
 	else
 	{
@@ -164,7 +539,8 @@ void UEmotionComponent::GetDominantEmotion(FGameplayTag& OutEmotionTag, float& O
 
 FVector2D UEmotionComponent::GetVACoordinate() const
 {
-	return EmotionState ? EmotionState->VACoordinate : FVector2D::ZeroVector;
+	const FEmotionStateData* StateData = GetStateData();
+	return StateData ? StateData->GetVACoordinate() : FVector2D::ZeroVector;
 }
 
 void UEmotionComponent::SetVACoordinate(const FVector2D& NewVACoordinate)
@@ -172,22 +548,32 @@ void UEmotionComponent::SetVACoordinate(const FVector2D& NewVACoordinate)
 	// Ensure the emotion state is initialized
 	InitializeEmotionState();
 	
-	// Store previous coordinate for change detection
-	FVector2D PreviousVA = EmotionState->VACoordinate;
+	if (IsWaitingForEmotionLibrary())
+	{
+		PendingVACoordinate = NewVACoordinate;
+		return;
+	}
 	
 	// Set the new coordinate
-	EmotionState->VACoordinate = NewVACoordinate;
+	FEmotionStateData* StateData = GetStateData();
+	if (!StateData)
+	{
+		return;
+	}
+	StateData->SetVACoordinate(NewVACoordinate);
 	
-	// Notify listeners if coordinate changed
-	if (!PreviousVA.Equals(NewVACoordinate, 0.01f))
+	// Notify listeners if coordinate changed, deferred notifications pick it up after the next update
+	if (!bDeferChangeNotifications && !LastNotifiedVA.Equals(NewVACoordinate, VAChangeThreshold))
 	{
+		LastNotifiedVA = NewVACoordinate;
 		BroadcastVACoordinateChanged(NewVACoordinate);
 	}
 }
 
 float UEmotionComponent::GetInfluenceRadius() const
 {
-	return EmotionState ? EmotionState->InfluenceRadius : 0.0f;
+	const FEmotionStateData* StateData = GetStateData();
+	return StateData ? StateData->InfluenceRadius : 0.0f;
 }
 
 void UEmotionComponent::SetInfluenceRadius(float NewRadius)
@@ -196,12 +582,16 @@ void UEmotionComponent::SetInfluenceRadius(float NewRadius)
 	InitializeEmotionState();
 	
 	// Set the new radius
-	EmotionState->InfluenceRadius = FMath::Max(0.0f, NewRadius);
+	if (FEmotionStateData* StateData = GetStateData())
+	{
+		StateData->InfluenceRadius = FMath::Max(0.0f, NewRadius);
+	}
 }
 
 TArray<UEmotionDefinition*> UEmotionComponent::FindEmotionsInRadius(float Radius) const
 {
-	return EmotionState ? EmotionState->FindEmotionsInRadius(Radius) : TArray<UEmotionDefinition*>();
+	const FEmotionStateData* StateData = GetStateData();
+	return StateData ? StateData->FindEmotionsInRadius(Radius) : TArray<UEmotionDefinition*>();
 }
 
 FString UEmotionComponent::GetOwnerName() const
@@ -213,17 +603,23 @@ FString UEmotionComponent::GetOwnerName() const
 	return TEXT("Unknown");
 }
 
-void UEmotionComponent::BroadcastEmotionChanged(const FGameplayTag& EmotionTag, float Intensity)
+void UEmotionComponent::BroadcastEmotionsChanged(const TArray<FEmotionChange>& Changes)
 {
-	// Broadcast the emotion change event
-	OnEmotionChanged.Broadcast(EmotionTag, Intensity);
+	// Per-emotion event, fired once per net change in the set
+	for (const FEmotionChange& Change : Changes)
+	{
+		OnEmotionChanged.Broadcast(Change.EmotionTag, Change.NewIntensity);
+	}
 	
-	// Also notify the subsystem about the change
+	// Broadcast the whole change set
+	OnEmotionsChanged.Broadcast(Changes);
+	
+	// Also notify the subsystem about the change set
 	if (UWorld* World = GetWorld())
 	{
 		if (UEmotionSubsystem* EmotionSubsystem = World->GetSubsystem<UEmotionSubsystem>())
 		{
-			EmotionSubsystem->NotifyEmotionChanged(this, EmotionTag, Intensity);
+			EmotionSubsystem->NotifyEmotionsChanged(this, Changes);
 		}
 	}
 }
@@ -255,7 +651,7 @@ bool UEmotionComponent::ReceiveEmotionalInfluence(AActor* Influencer, const FGam
 	}
 	
 	// Check if this component is immune to the given emotion
-	if (ImmuneEmotions.HasTag(EmotionTag))
+	if (IsImmuneToEmotion(EmotionTag))
 	{
 		return false;
 	}
@@ -264,7 +660,11 @@ bool UEmotionComponent::ReceiveEmotionalInfluence(AActor* Influencer, const FGam
 	float ModifiedIntensity = Intensity * EmotionalSusceptibility;
 	
 	// Apply the emotion
-	if (bAdditive)
+	if (bAdditive && BufferWhileLibraryLoads(EEmotionDeltaOperation::Add, EmotionTag, ModifiedIntensity))
+	{
+		// The current intensity is not known yet, the buffered change adds to it once the library is loaded
+	}
+	else if (bAdditive)
 	{
 		// Get current intensity and add to it
 		float CurrentIntensity = GetEmotionIntensity(EmotionTag);
@@ -284,13 +684,46 @@ bool UEmotionComponent::ReceiveEmotionalInfluence(AActor* Influencer, const FGam
 
 void UEmotionComponent::ApplyEmotionalStimulus(const FGameplayTag& EmotionTag, float Intensity)
 {
-	// Ensure the emotion state is initialized
-	InitializeEmotionState();
-	
 	// Apply the emotion directly without influence checks
 	AddEmotion(EmotionTag, Intensity);
 }
 
+bool UEmotionComponent::IsImmuneToEmotion(const FGameplayTag& EmotionTag) const
+{
+	const FEmotionStateData* StateData = GetStateData();
+	const UEmotionLibrary* Library = StateData ? StateData->GetEmotionLibrary() : nullptr;
+	if (Library && Library->GetTagSpace().IsValid())
+	{
+		// Tags outside the library's space are not covered by the mask
+		const int32 TagIndex = Library->GetTagSpace().GetTagIndex(EmotionTag);
+		if (TagIndex != INDEX_NONE)
+		{
+			return ImmuneEmotionMask.TestBit(TagIndex);
+		}
+	}
+	
+	return ImmuneEmotions.HasTag(EmotionTag) || (Archetype && Archetype->ImmuneEmotions.HasTag(EmotionTag));
+}
+
+void UEmotionComponent::SetImmuneEmotions(const FGameplayTagContainer& NewImmuneEmotions)
+{
+	ImmuneEmotions = NewImmuneEmotions;
+	UpdateImmuneEmotionMask();
+}
+
+void UEmotionComponent::UpdateImmuneEmotionMask()
+{
+	const FEmotionStateData* StateData = AsConst(*this).GetStateData();
+	const UEmotionLibrary* Library = StateData ? StateData->GetEmotionLibrary() : nullptr;
+	ImmuneEmotionMask = Library ? Library->GetTagSpace().MakeMask(ImmuneEmotions) : FEmotionTagMask();
+	
+	// The archetype's immunities apply on top of the component's own
+	if (Library && Archetype)
+	{
+		ImmuneEmotionMask |= Library->GetTagSpace().MakeMask(Archetype->ImmuneEmotions);
+	}
+}
+
 void UEmotionComponent::SetEmotionalSusceptibility(float NewSusceptibility)
 {
 	EmotionalSusceptibility = FMath::Max(0.0f, NewSusceptibility);
@@ -303,7 +736,7 @@ bool UEmotionComponent::CanReceiveInfluenceFrom(AActor* Influencer) const
 		return false;
 	}
 	
-	// Check if the influencer is in the blocked list
+	// Check if the influencer is in the blocked list, the archetype's included
 	for (TSubclassOf<AActor> BlockedClass : BlockedInfluencers)
 	{
 		if (BlockedClass && Influencer->IsA(BlockedClass))
@@ -312,14 +745,28 @@ bool UEmotionComponent::CanReceiveInfluenceFrom(AActor* Influencer) const
 		}
 	}
 	
+	if (Archetype)
+	{
+		for (TSubclassOf<AActor> BlockedClass : Archetype->BlockedInfluencers)
+		{
+			if (BlockedClass && Influencer->IsA(BlockedClass))
+			{
+				return false;
+			}
+		}
+	}
+	
+	// The component's allowed list replaces the archetype's
+	const TArray<TSubclassOf<AActor>>& Allowed = (AllowedInfluencers.Num() == 0 && Archetype) ? Archetype->AllowedInfluencers : AllowedInfluencers;
+	
 	// If allowed list is empty, all non-blocked actors are allowed
-	if (AllowedInfluencers.Num() == 0)
+	if (Allowed.Num() == 0)
 	{
 		return true;
 	}
 	
 	// Check if the influencer is in the allowed list
-	for (TSubclassOf<AActor> AllowedClass : AllowedInfluencers)
+	for (TSubclassOf<AActor> AllowedClass : Allowed)
 	{
 		if (AllowedClass && Influencer->IsA(AllowedClass))
 		{
@@ -333,29 +780,364 @@ bool UEmotionComponent::CanReceiveInfluenceFrom(AActor* Influencer) const
 
 void UEmotionComponent::InitializeEmotionState()
 {
-	if (!EmotionState)
+	LLM_SCOPE_BYTAG(EmotionEngine);
+	
+	// Already initialized, keep the current emotions
+	if (const FEmotionStateData* StateData = AsConst(*this).GetStateData())
 	{
-		EmotionState = NewObject<UEmotionState>(this, TEXT("EmotionState"));
+		if (StateData->GetEmotionLibrary())
+		{
+			SyncStateSettings();
+			return;
+		}
+	}
+	
+	UEmotionSubsystem* EmotionSubsystem = nullptr;
+	if (UWorld* World = GetWorld())
+	{
+		EmotionSubsystem = World->GetSubsystem<UEmotionSubsystem>();
+	}
+	
+	// Library that still has to be streamed in before the state can be initialized
+	FSoftObjectPath PendingLibraryPath;
+	
+	UEmotionLibrary* Library = EmotionLibrary;
+	if (!Library && !StreamedEmotionLibrary.IsNull())
+	{
+		Library = StreamedEmotionLibrary.Get();
+		PendingLibraryPath = StreamedEmotionLibrary.ToSoftObjectPath();
+	}
+	else if (!Library && Archetype && Archetype->EmotionLibrary)
+	{
+		Library = Archetype->EmotionLibrary;
+	}
+	else if (!Library && EmotionSubsystem)
+	{
+		// Use the world's default library, cached by the subsystem
+		Library = EmotionSubsystem->GetDefaultEmotionLibrary();
+		if (!Library && EmotionSubsystem->IsLoadingDefaultEmotionLibrary())
+		{
+			PendingLibraryPath = UEmotionSystemLibrary::GetDefaultEmotionLibraryPath();
+		}
+	}
+	
+	// Wait for the library instead of loading it synchronously, changes are buffered until it arrives
+	if (!Library && !PendingLibraryPath.IsNull())
+	{
+		Library = RequestEmotionLibraryLoad(PendingLibraryPath);
+		if (!Library)
+		{
+			return;
+		}
+	}
+	
+	// Baseline shared by the archetype's agents using the same library, built for the library resolved above
+	const FEmotionStateData* Baseline = nullptr;
+	if (Archetype)
+	{
+		ApplyArchetypeSettings();
+		Baseline = Archetype->GetBaselineState(Library);
+	}
+	
+	if (bUsePooledState && EmotionSubsystem && !IsUsingPooledState())
+	{
+		StatePoolOwner = EmotionSubsystem;
+		
+		if (Baseline && Baseline->IsAtRest())
+		{
+			// Nothing to tick until the agent diverges, read the shared baseline until then
+			ArchetypeBaseline = Baseline;
+		}
+		else if (Library)
+		{
+			// Pooled states are only allocated once a library is known, they are initialized with it
+			PooledStateHandle = EmotionSubsystem->AcquirePooledState(this, Library);
+			if (FEmotionStateData* StateData = EmotionSubsystem->GetStatePool().Get(PooledStateHandle); StateData && Baseline)
+			{
+				StateData->InitializeFromBaseline(*Baseline, GetStateTime());
+			}
+		}
+	}
+	else if (!IsUsingPooledState())
+	{
+		if (!EmotionState)
+		{
+			EmotionState = NewObject<UEmotionState>(this, TEXT("EmotionState"));
+		}
+		
+		if (Library)
+		{
+			EmotionState->Initialize(Library);
+		}
+		
+		// Standalone states always own a copy of the baseline
+		if (FEmotionStateData* StateData = EmotionState->GetStateData(); StateData && Baseline)
+		{
+			StateData->InitializeFromBaseline(*Baseline, GetStateTime());
+		}
+	}
+	
+	SyncStateSettings();
+	UpdateImmuneEmotionMask();
+}
+
+UEmotionLibrary* UEmotionComponent::RequestEmotionLibraryLoad(const FSoftObjectPath& LibraryPath)
+{
+	if (!LibraryLoadHandle.IsValid())
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("UEmotionComponent - %s waits for emotion library %s"), *GetOwnerName(), *LibraryPath.ToString());
+		LibraryLoadHandle = UEmotionSystemLibrary::LoadEmotionLibraryAsync(LibraryPath,
+			FStreamableDelegate::CreateUObject(this, &UEmotionComponent::OnEmotionLibraryLoaded));
+	}
+	
+	if (IsWaitingForEmotionLibrary())
+	{
+		return nullptr;
+	}
+	
+	// Loaded, or already in memory and nothing had to be loaded
+	UEmotionLibrary* Library = Cast<UEmotionLibrary>(LibraryPath.ResolveObject());
+	UE_CLOG(!Library, LogTemp, Warning, TEXT("UEmotionComponent - Failed to load emotion library %s for %s"), *LibraryPath.ToString(), *GetOwnerName());
+	return Library;
+}
+
+void UEmotionComponent::OnEmotionLibraryLoaded()
+{
+	// Loads finishing inside RequestEmotionLibraryLoad are picked up by the initialization that started them
+	if (!LibraryLoadHandle.IsValid() || IsEmotionStateInitialized())
+	{
+		return;
+	}
+	
+	InitializeEmotionState();
+	if (!IsEmotionStateInitialized())
+	{
+		// Nothing to replay into, the changes are lost like any change made without a library
+		PendingStimuli.Empty();
+		PendingVACoordinate.Reset();
+		return;
+	}
+	
+	// Same tick setup as BeginPlay
+	if (HasBegunPlay())
+	{
+		SetComponentTickEnabled(!IsUsingPooledState() && !IsAtArchetypeBaseline());
+	}
+	
+	ReplayPendingStimuli();
+}
+
+bool UEmotionComponent::BufferWhileLibraryLoads(EEmotionDeltaOperation Operation, const FGameplayTag& EmotionTag, float Intensity)
+{
+	// Starts the load if the state has not asked for its library yet
+	InitializeEmotionState();
+	if (!IsWaitingForEmotionLibrary() || !EmotionTag.IsValid())
+	{
+		return false;
+	}
+	
+	if (Operation != EEmotionDeltaOperation::Add)
+	{
+		// Setting or removing the emotion overrides every change buffered for it before
+		PendingStimuli.RemoveAll([&EmotionTag](const FEmotionPendingStimulus& Stimulus)
+		{
+			return Stimulus.EmotionTag == EmotionTag;
+		});
+	}
+	else if (FEmotionPendingStimulus* Pending = PendingStimuli.FindLastByPredicate([&EmotionTag](const FEmotionPendingStimulus& Stimulus)
+	{
+		return Stimulus.EmotionTag == EmotionTag;
+	}))
+	{
+		// Merge only when it gives the same result as applying both in order. Adding to a set or removed emotion starts
+		// from a known intensity, and adds of the same sign clamp at the same bound whether applied apart or summed.
+		// Adds of opposite signs are not merged, the first may clamp before the second applies.
+		if (Pending->Operation != EEmotionDeltaOperation::Add)
+		{
+			const float BaseIntensity = Pending->Operation == EEmotionDeltaOperation::Set ? Pending->GetIntensity() : 0.0f;
+			Pending->Operation = EEmotionDeltaOperation::Set;
+			Pending->SetIntensity(FMath::Clamp(BaseIntensity + Intensity, 0.0f, 100.0f));
+			return true;
+		}
+		
+		const float PendingIntensity = Pending->GetIntensity();
+		if (PendingIntensity * Intensity >= 0.0f)
+		{
+			Pending->SetIntensity(FMath::Clamp(PendingIntensity + Intensity, -100.0f, 100.0f));
+			return true;
+		}
 	}
 	
-	if (EmotionState && EmotionLibrary)
+	if (PendingStimuli.Num() >= FEmotionPendingStimulus::MaxPendingStimuli)
 	{
-		EmotionState->Initialize(EmotionLibrary);
+		UE_LOG(LogTemp, Warning, TEXT("UEmotionComponent - Dropping an emotion change for %s, %d changes are already buffered while its library loads"),
+			*GetOwnerName(), PendingStimuli.Num());
+		return true;
 	}
-	else if (EmotionState)
+	
+	FEmotionPendingStimulus& Stimulus = PendingStimuli.AddDefaulted_GetRef();
+	Stimulus.EmotionTag = EmotionTag;
+	Stimulus.Operation = Operation;
+	Stimulus.SetIntensity(Operation == EEmotionDeltaOperation::Remove ? 0.0f : Intensity);
+	return true;
+}
+
+void UEmotionComponent::ReplayPendingStimuli()
+{
+	if (PendingStimuli.Num() > 0)
 	{
-		// Try to find a default emotion library from the subsystem
-		if (UWorld* World = GetWorld())
+		UE_LOG(LogTemp, Verbose, TEXT("UEmotionComponent - Replaying %d emotion changes buffered while %s was loading its library"), PendingStimuli.Num(), *GetOwnerName());
+		
+		const TArray<FEmotionPendingStimulus> Stimuli = MoveTemp(PendingStimuli);
+		PendingStimuli.Empty();
+		
+		BeginEmotionBatch();
+		for (const FEmotionPendingStimulus& Stimulus : Stimuli)
 		{
-			if (UEmotionSubsystem* EmotionSubsystem = World->GetSubsystem<UEmotionSubsystem>())
+			const float Intensity = Stimulus.GetIntensity();
+			switch (Stimulus.Operation)
 			{
-				// Use the EmotionSystemLibrary to get the default library
-				UEmotionLibrary* DefaultLibrary = UEmotionSystemLibrary::GetDefaultEmotionLibrary();
-				if (DefaultLibrary)
+			case EEmotionDeltaOperation::Add:
+				// AddEmotion ignores negative intensities, lowering influences add to the current intensity instead
+				if (Intensity >= 0.0f)
+				{
+					AddEmotion(Stimulus.EmotionTag, Intensity);
+				}
+				else
 				{
-				    EmotionState->Initialize(DefaultLibrary);
+					SetEmotionIntensity(Stimulus.EmotionTag, GetEmotionIntensity(Stimulus.EmotionTag) + Intensity);
 				}
+				break;
+			case EEmotionDeltaOperation::Set:
+				SetEmotionIntensity(Stimulus.EmotionTag, Intensity);
+				break;
+			case EEmotionDeltaOperation::Remove:
+				RemoveEmotion(Stimulus.EmotionTag);
+				break;
 			}
 		}
+		CommitEmotionBatch();
+	}
+	
+	if (PendingVACoordinate.IsSet())
+	{
+		const FVector2D VACoordinate = PendingVACoordinate.GetValue();
+		PendingVACoordinate.Reset();
+		SetVACoordinate(VACoordinate);
+	}
+}
+
+void UEmotionComponent::ApplyArchetypeSettings()
+{
+	EmotionalSusceptibility = Archetype->EmotionalSusceptibility;
+	SpringStiffness = Archetype->SpringStiffness;
+	DampingFactor = Archetype->DampingFactor;
+}
+
+void UEmotionComponent::MaterializeArchetypeState()
+{
+	const FEmotionStateData* Baseline = ArchetypeBaseline;
+	ArchetypeBaseline = nullptr;
+	
+	UEmotionSubsystem* EmotionSubsystem = StatePoolOwner.Get();
+	if (!Baseline || !EmotionSubsystem)
+	{
+		return;
+	}
+	
+	// Copy of the baseline, the agent's changes apply to it from here on
+	PooledStateHandle = EmotionSubsystem->AcquirePooledState(this, Baseline->GetEmotionLibrary());
+	if (FEmotionStateData* StateData = EmotionSubsystem->GetStatePool().Get(PooledStateHandle))
+	{
+		StateData->InitializeFromBaseline(*Baseline, GetStateTime());
+	}
+	SyncStateSettings();
+}
+
+bool UEmotionComponent::TryCollapseToArchetypeBaseline()
+{
+	// A Blueprint view or an open batch still points at the component's own state
+	if (!Archetype || !IsUsingPooledState() || EmotionState || BatchDepth > 0)
+	{
+		return false;
+	}
+	
+	const FEmotionStateData* StateData = AsConst(*this).GetStateData();
+	if (!StateData)
+	{
+		return false;
+	}
+	
+	const FEmotionStateData* Baseline = Archetype->GetBaselineState(StateData->GetEmotionLibrary());
+	if (!Baseline || !Baseline->IsAtRest() || !StateData->IsEquivalentTo(*Baseline))
+	{
+		return false;
+	}
+	
+	ReleasePooledState();
+	ArchetypeBaseline = Baseline;
+	
+	// Keep the subsystem to materialize from, ReleasePooledState forgets it
+	if (UWorld* World = GetWorld())
+	{
+		StatePoolOwner = World->GetSubsystem<UEmotionSubsystem>();
+	}
+	return true;
+}
+
+void UEmotionComponent::SetArchetype(UEmotionArchetype* NewArchetype)
+{
+	if (IsEmotionStateInitialized())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UEmotionComponent::SetArchetype - Emotion state of %s is already initialized"), *GetOwnerName());
+		return;
+	}
+	
+	Archetype = NewArchetype;
+}
+
+bool UEmotionComponent::IsEmotionStateInitialized() const
+{
+	const FEmotionStateData* StateData = GetStateData();
+	return StateData && StateData->GetEmotionLibrary();
+}
+
+void UEmotionComponent::AdoptPooledState(UEmotionSubsystem* EmotionSubsystem, const FEmotionStateHandle& Handle)
+{
+	ReleasePooledState();
+	
+	PooledStateHandle = Handle;
+	StatePoolOwner = EmotionSubsystem;
+	
+	if (Archetype)
+	{
+		ApplyArchetypeSettings();
+	}
+	SyncStateSettings();
+	UpdateImmuneEmotionMask();
+}
+
+void UEmotionComponent::GetEmotionMemoryUsage(SIZE_T& OutOwnedBytes, SIZE_T& OutPooledBytes, SIZE_T& OutQueueBytes) const
+{
+	OutOwnedBytes = 0;
+	OutPooledBytes = 0;
+	
+	if (EmotionState)
+	{
+		OutOwnedBytes += sizeof(UEmotionState);
+		if (!EmotionState->IsPooledView())
+		{
+			const FEmotionStateData* StateData = EmotionState->GetStateData();
+			OutOwnedBytes += StateData ? StateData->GetAllocatedSize() : 0;
+		}
+	}
+	
+	// An agent at its archetype baseline owns nothing, the baseline is counted once per archetype
+	if (IsUsingPooledState())
+	{
+		const FEmotionStateData* StateData = GetStateData();
+		OutPooledBytes = StateData ? sizeof(FEmotionStateData) + StateData->GetAllocatedSize() : 0;
 	}
+	
+	OutQueueBytes = BatchBaseline.GetAllocatedSize() + LastNotifiedIntensities.GetAllocatedSize() + PendingStimuli.GetAllocatedSize();
 }
@@ -1,12 +1,42 @@
 #include "EmotionData.h"
+#include "EmotionEngine.h"
+#include "EmotionEngineSettings.h"
+#include "Algo/Sort.h"
+#include "Algo/Unique.h"
+#include "Engine/AssetManager.h"
+#include "Engine/Texture2D.h"
 #include "Kismet/KismetMathLibrary.h"
+#if WITH_EDITOR
+#include "Interfaces/ITargetPlatform.h"
+#endif
+
+namespace EmotionDataPrivate
+{
+    // Bumped whenever an emotion asset is edited so libraries know to recompile their runtime data
+    static uint32 DataRevision = 1;
+
+    // Source of UEmotionLibrary::CompileId, 0 is never handed out
+    static uint32 NextCompileId = 1;
+
+#if WITH_EDITOR
+    // Presentation data left out of a server platform's cook, counted once per saved definition
+    struct FStrippedPresentationData
+    {
+        int32 NumDefinitions = 0;
+        SIZE_T TextBytes = 0;
+        SIZE_T IconBytes = 0;
+    };
+
+    // Stripped data of the current cook by platform name, reported once the cook finishes
+    static TMap<FString, FStrippedPresentationData> StrippedByPlatform;
+#endif
+}
 
 // UEmotionDefinition implementation
 UEmotionDefinition::UEmotionDefinition()
 {
     // Initialize with default values
     //AssetImportData = CreateDefaultSubobject<UAssetImportData>(TEXT("AssetImportData"));
-    Emotion.Intensity = 0.0f;
     Emotion.DecayRate = 1.0f;
     Emotion.InfluenceRadius = 0.1f;
     Emotion.Type = EEmotionType::Core;
@@ -24,21 +54,93 @@ void UEmotionDefinition::PostInitProperties()
     Super::PostInitProperties();
 }
 
-FGameplayTagContainer UEmotionDefinition::GetAllEmotionTags() const
+#if WITH_EDITOR
+void UEmotionDefinition::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
 {
-    return Emotion.GetAllEmotionTags();
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+    UEmotionLibrary::NotifyEmotionDataChanged();
 }
 
-FGameplayTagContainer UEmotionDefinition::UpdateIntensity(float DeltaIntensity)
+void UCombinedEmotionMapping::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
 {
-    // Store previous tags to compare later
-    FGameplayTagContainer PreviousTags = GetAllEmotionTags();
-    
-    // Update intensity, clamping between 0 and 100
-    Emotion.Intensity = FMath::Clamp(Emotion.Intensity + DeltaIntensity, 0.0f, 100.0f);
-    
-    // Get new tags after intensity update
-    FGameplayTagContainer NewTags = GetAllEmotionTags();
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+    UEmotionLibrary::NotifyEmotionDataChanged();
+}
+#endif
+
+void UEmotionDefinition::Serialize(FArchive& Ar)
+{
+#if WITH_EDITOR
+    // Servers never present emotions: save without text and icon, so the icon is not cooked or loaded with the definition.
+    // Saving serializes the definition more than once, the harvest pass must not see the icon either or it is cooked as a
+    // dependency, but only the final save into the package is counted
+    const ITargetPlatform* CookingTarget = Ar.IsSaving() && Ar.IsCooking() ? Ar.CookingTarget() : nullptr;
+    if (CookingTarget && CookingTarget->IsServerOnly() && GetDefault<UEmotionEngineSettings>()->bStripPresentationDataForServer)
+    {
+        const FText SavedDisplayName = DisplayName;
+        const FText SavedDescription = Description;
+        const TSoftObjectPtr<UTexture2D> SavedIcon = Icon;
+        DisplayName = FText::GetEmpty();
+        Description = FText::GetEmpty();
+        Icon.Reset();
+
+        Super::Serialize(Ar);
+
+        DisplayName = SavedDisplayName;
+        Description = SavedDescription;
+        Icon = SavedIcon;
+
+        if (Ar.IsPersistent() && !Ar.IsObjectReferenceCollector())
+        {
+            UTexture2D* LoadedIcon = Icon.Get();
+            EmotionDataPrivate::FStrippedPresentationData& Stripped = EmotionDataPrivate::StrippedByPlatform.FindOrAdd(CookingTarget->PlatformName());
+            ++Stripped.NumDefinitions;
+            Stripped.TextBytes += (DisplayName.ToString().Len() + Description.ToString().Len()) * sizeof(TCHAR);
+            Stripped.IconBytes += LoadedIcon ? LoadedIcon->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal) : 0;
+        }
+        return;
+    }
+#endif
+
+    Super::Serialize(Ar);
+}
+
+#if WITH_EDITOR
+void UEmotionDefinition::ReportStrippedPresentationData()
+{
+    for (const TPair<FString, EmotionDataPrivate::FStrippedPresentationData>& Pair : EmotionDataPrivate::StrippedByPlatform)
+    {
+        UE_LOG(LogTemp, Display, TEXT("Stripped presentation data of %d emotion definitions for %s: %.1f KB of text and an estimated %.1f KB of icons left out"),
+            Pair.Value.NumDefinitions, *Pair.Key, Pair.Value.TextBytes / 1024.0f, Pair.Value.IconBytes / 1024.0f);
+    }
+    EmotionDataPrivate::StrippedByPlatform.Reset();
+}
+#endif
+
+UTexture2D* UEmotionDefinition::GetLoadedIcon() const
+{
+    return Icon.Get();
+}
+
+TSharedPtr<FStreamableHandle> UEmotionDefinition::RequestIconLoad(FStreamableDelegate OnLoaded) const
+{
+    if (Icon.IsNull())
+    {
+        return nullptr;
+    }
+
+    return UAssetManager::GetStreamableManager().RequestAsyncLoad(Icon.ToSoftObjectPath(), MoveTemp(OnLoaded));
+}
+
+FGameplayTagContainer UEmotionDefinition::GetAllEmotionTags(float Intensity) const
+{
+    return Emotion.GetAllEmotionTags(Intensity);
+}
+
+FGameplayTagContainer UEmotionDefinition::GetNewlyTriggeredTags(float PreviousIntensity, float NewIntensity) const
+{
+    const FGameplayTagContainer PreviousTags = GetAllEmotionTags(FMath::Clamp(PreviousIntensity, 0.0f, 100.0f));
+    const FGameplayTagContainer NewTags = GetAllEmotionTags(FMath::Clamp(NewIntensity, 0.0f, 100.0f));
     
     // Return only the newly triggered tags (tags that weren't active before)
     FGameplayTagContainer TriggeredTags;
@@ -53,14 +155,14 @@ FGameplayTagContainer UEmotionDefinition::UpdateIntensity(float DeltaIntensity)
     return TriggeredTags;
 }
 
-void UEmotionDefinition::ApplyDecay(float DeltaTime)
+float UEmotionDefinition::GetDecayedIntensity(float Intensity, float DeltaTime) const
 {
     // Apply decay based on the decay rate and time passed
-    if (Emotion.Intensity > 0.0f && Emotion.DecayRate > 0.0f)
+    if (Intensity > 0.0f && Emotion.DecayRate > 0.0f)
     {
-        float DecayAmount = Emotion.DecayRate * DeltaTime;
-        Emotion.Intensity = FMath::Max(0.0f, Emotion.Intensity - DecayAmount);
+        return FMath::Max(0.0f, Intensity - Emotion.DecayRate * DeltaTime);
     }
+    return Intensity;
 }
 
 bool UEmotionDefinition::IsOppositeEmotion(const FGameplayTag& EmotionTag) const
@@ -69,133 +171,880 @@ bool UEmotionDefinition::IsOppositeEmotion(const FGameplayTag& EmotionTag) const
 }
 
 // UEmotionLibrary implementation
-UEmotionDefinition* UEmotionLibrary::GetEmotionByTag(const FGameplayTag& EmotionTag) const
+const FName UEmotionLibrary::IconBundle(TEXT("UI"));
+
+void UEmotionLibrary::PostLoad()
 {
-    for (UEmotionDefinition* EmotionData : Emotions)
+    Super::PostLoad();
+    BuildRuntimeData();
+}
+
+#if WITH_EDITOR
+void UEmotionLibrary::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+    NotifyEmotionDataChanged();
+}
+#endif
+
+#if WITH_EDITORONLY_DATA
+void UEmotionLibrary::UpdateAssetBundleData()
+{
+    Super::UpdateAssetBundleData();
+
+    // Icons are soft references held by separate emotion assets, list them here so the library's bundle data covers them
+    for (const UEmotionDefinition* Emotion : GetRuntimeEmotions())
     {
-        if (EmotionData && EmotionData->Emotion.Tag == EmotionTag)
+        if (Emotion && !Emotion->Icon.IsNull())
         {
-            return EmotionData;
+            AssetBundleData.AddBundleAsset(IconBundle, Emotion->Icon.ToSoftObjectPath().GetAssetPath());
         }
     }
-    return nullptr;
 }
+#endif
 
-TArray<UEmotionDefinition*> UEmotionLibrary::GetOppositeEmotions(const FGameplayTag& EmotionTag) const
+void UEmotionLibrary::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
 {
-    TArray<UEmotionDefinition*> Result;
-    UEmotionDefinition* SourceEmotion = GetEmotionByTag(EmotionTag);
-    
-    if (SourceEmotion)
+    Super::GetResourceSizeEx(CumulativeResourceSize);
+    CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetLibraryAllocatedSize() - sizeof(UEmotionLibrary));
+}
+
+SIZE_T UEmotionLibrary::GetLibraryAllocatedSize() const
+{
+    SIZE_T BracketTagBytes = 0;
+    for (const FEmotionCompiledBracket& Bracket : CompiledBrackets)
+    {
+        BracketTagBytes += Bracket.Tags.GetGameplayTagArray().GetAllocatedSize();
+    }
+
+    return sizeof(UEmotionLibrary)
+        + Emotions.GetAllocatedSize() + CoreEmotions.GetAllocatedSize() + CombineEmotions.GetAllocatedSize()
+        + RuntimeEmotions.GetAllocatedSize() + RuntimeEmotionTags.GetAllocatedSize() + RuntimeEmotionIndices.GetAllocatedSize()
+        + CompiledEmotions.GetAllocatedSize() + CompiledBrackets.GetAllocatedSize() + BracketTagBytes
+        + CompiledLinks.GetAllocatedSize() + CompiledLinkCells.GetAllocatedSize() + CompiledLinkVariations.GetAllocatedSize()
+        + SpatialIndex.GetAllocatedSize() + ZoneTable.GetAllocatedSize() + TagSpace.GetAllocatedSize() + CombinationTable.GetAllocatedSize();
+}
+
+void UEmotionLibrary::NotifyEmotionDataChanged()
+{
+    ++EmotionDataPrivate::DataRevision;
+}
+
+void UEmotionLibrary::EnsureRuntimeData() const
+{
+    if (CompiledRevision != EmotionDataPrivate::DataRevision)
+    {
+        // Compiled on load and after edits, both on the game thread. Parallel readers rely on the data not changing under them.
+        checkf(IsInGameThread(), TEXT("Emotion library %s is compiled lazily off the game thread, compile it with BuildRuntimeData first"), *GetName());
+        const_cast<UEmotionLibrary*>(this)->BuildRuntimeData();
+    }
+}
+
+void UEmotionLibrary::BuildRuntimeData()
+{
+    LLM_SCOPE_BYTAG(EmotionEngine);
+
+    TArray<FGameplayTag> ReferencedTags;
+    GatherReferencedTags(ReferencedTags);
+    TagSpace.Build(ReferencedTags);
+
+    // Every emotion that can be active in a state participates in the combination index
+    BuildRuntimeEmotions();
+    BuildCompiledEmotions();
+    BuildZoneTable();
+    CombinationTable.Build(CombineEmotions, RuntimeEmotions, TagSpace);
+
+    CompiledRevision = EmotionDataPrivate::DataRevision;
+    CompileId = EmotionDataPrivate::NextCompileId++;
+}
+
+void UEmotionLibrary::BuildRuntimeEmotions()
+{
+    RuntimeEmotions.Reset();
+    RuntimeEmotionTags.Reset();
+    RuntimeEmotionIndices.Reset();
+
+    auto AddRuntimeEmotion = [this](UEmotionDefinition* EmotionData)
     {
-        // Get the direct opposite
-        if (SourceEmotion->Emotion.OppositeEmotionTag.IsValid())
+        if (!EmotionData || !EmotionData->Emotion.Tag.IsValid() || RuntimeEmotionIndices.Contains(EmotionData->Emotion.Tag))
+        {
+            return;
+        }
+
+        if (RuntimeEmotions.Num() >= MaxRuntimeEmotions)
         {
-            UEmotionDefinition* OppositeEmotion = GetEmotionByTag(SourceEmotion->Emotion.OppositeEmotionTag);
-            if (OppositeEmotion)
+            UE_LOG(LogTemp, Warning, TEXT("UEmotionLibrary::BuildRuntimeEmotions - %s has more than %d emotions, %s is ignored"),
+                *GetName(), MaxRuntimeEmotions, *EmotionData->GetName());
+            return;
+        }
+
+        RuntimeEmotionIndices.Add(EmotionData->Emotion.Tag, RuntimeEmotions.Add(EmotionData));
+        RuntimeEmotionTags.Add(EmotionData->Emotion.Tag);
+    };
+
+    for (UEmotionDefinition* EmotionData : Emotions)
+    {
+        AddRuntimeEmotion(EmotionData);
+    }
+    NumAuthoredRuntimeEmotions = RuntimeEmotions.Num();
+
+    for (const UCombinedEmotionMapping* Mapping : CombineEmotions)
+    {
+        if (Mapping)
+        {
+            for (const FCombineEmotionMapping& CombineMapping : Mapping->CombinedEmotions)
             {
-                Result.Add(OppositeEmotion);
+                AddRuntimeEmotion(CombineMapping.ResultEmotion);
             }
         }
     }
-    
-    return Result;
 }
 
-FVector2D UEmotionDefinition::GetEmotionCoordinate() const
+void UEmotionLibrary::BuildCompiledEmotions()
 {
-	return Emotion.VACoordinate.GetCartesianCoordinate();
-}
+    CompiledEmotions.Reset(RuntimeEmotions.Num());
+    CompiledBrackets.Reset();
+    CompiledLinks.Reset();
+    CompiledLinkCells.Reset();
+    CompiledLinkVariations.Reset();
 
-TArray<UEmotionDefinition*> UEmotionLibrary::GetAdjacentEmotions(const FGameplayTag& EmotionTag, float MaxDistance) const
-{
-    TArray<UEmotionDefinition*> Result;
-    UEmotionDefinition* SourceEmotion = GetEmotionByTag(EmotionTag);
-    
-    if (SourceEmotion)
+    // Bracket starts ordered by intensity, an inclusive start comes before an exclusive one at the same intensity
+    struct FBracketStart
+    {
+        float Value;
+        bool bExclusive;
+
+        bool operator<(const FBracketStart& Other) const { return Value < Other.Value || (Value == Other.Value && !bExclusive && Other.bExclusive); }
+        bool operator<=(const FBracketStart& Other) const { return !(Other < *this); }
+        bool operator==(const FBracketStart& Other) const { return Value == Other.Value && bExclusive == Other.bExclusive; }
+    };
+
+    auto HasVariations = [](const FEmotionLink& Link)
+    {
+        return Link.VariationEmotionTags.ContainsByPredicate([](const FEmotionTriggerRange& Variation) { return Variation.EmotionTagTriggered.IsValid(); });
+    };
+    auto FindLinkedIndex = [this](const FEmotionLink& Link)
+    {
+        const int32* LinkedIndex = Link.LinkEmotion.IsValid() ? RuntimeEmotionIndices.Find(Link.LinkEmotion) : nullptr;
+        return LinkedIndex ? *LinkedIndex : INDEX_NONE;
+    };
+
+    // Derived tags only change where an intensity enters a range (Start, inclusive), leaves it (above End) or reaches
+    // a link threshold, and where a linked emotion's intensity enters or leaves a variation range of the link
+    TArray<TArray<FBracketStart>> BracketStarts;
+    BracketStarts.SetNum(RuntimeEmotions.Num());
+    for (int32 EmotionIndex = 0; EmotionIndex < RuntimeEmotions.Num(); ++EmotionIndex)
     {
-        // Find emotions within the specified distance in VA space
-        for (UEmotionDefinition* EmotionData : Emotions)
+        const FEmotion& Emotion = RuntimeEmotions[EmotionIndex]->Emotion;
+        BracketStarts[EmotionIndex].Add({ 0.0f, false });
+        for (const FEmotionTriggerRange& RangeEmotion : Emotion.RangeEmotionTags)
         {
-            if (EmotionData && EmotionData != SourceEmotion)
+            if (RangeEmotion.EmotionTagTriggered.IsValid())
+            {
+                BracketStarts[EmotionIndex].Add({ RangeEmotion.Start, false });
+                BracketStarts[EmotionIndex].Add({ RangeEmotion.End, true });
+            }
+        }
+        for (const FEmotionLink& Link : Emotion.LinkEmotions)
+        {
+            if (!HasVariations(Link))
+            {
+                continue;
+            }
+
+            BracketStarts[EmotionIndex].Add({ Link.Threshold, false });
+            const int32 LinkedIndex = FindLinkedIndex(Link);
+            if (LinkedIndex != INDEX_NONE)
             {
-                // Calculate distance in VA space
-                float Distance = FVector2D::Distance(SourceEmotion->GetEmotionCoordinate(), EmotionData->GetEmotionCoordinate());
-                
-                // Add to result if within the specified distance
-                if (Distance <= MaxDistance)
+                for (const FEmotionTriggerRange& Variation : Link.VariationEmotionTags)
                 {
-                    Result.Add(EmotionData);
+                    BracketStarts[LinkedIndex].Add({ Variation.Start, false });
+                    BracketStarts[LinkedIndex].Add({ Variation.End, true });
                 }
             }
         }
-        
-        // Sort by distance (closest first)
-        Result.Sort([SourceEmotion](const UEmotionDefinition& A, const UEmotionDefinition& B)
+    }
+
+    for (int32 EmotionIndex = 0; EmotionIndex < RuntimeEmotions.Num(); ++EmotionIndex)
+    {
+        const FEmotion& Emotion = RuntimeEmotions[EmotionIndex]->Emotion;
+
+        FEmotionCompiledEmotion& Compiled = CompiledEmotions.AddDefaulted_GetRef();
+        Compiled.Coordinate = Emotion.VACoordinate.GetCartesianCoordinate();
+        Compiled.DecayRate = Emotion.DecayRate;
+
+        const int32* OppositeIndex = Emotion.OppositeEmotionTag.IsValid() ? RuntimeEmotionIndices.Find(Emotion.OppositeEmotionTag) : nullptr;
+        Compiled.OppositeIndex = OppositeIndex ? *OppositeIndex : INDEX_NONE;
+
+        TArray<FBracketStart>& EmotionBracketStarts = BracketStarts[EmotionIndex];
+        EmotionBracketStarts.Sort();
+        EmotionBracketStarts.SetNum(Algo::Unique(EmotionBracketStarts));
+
+        Compiled.FirstBracket = CompiledBrackets.Num();
+        for (const FBracketStart& BracketStart : EmotionBracketStarts)
+        {
+            FEmotionCompiledBracket& Bracket = CompiledBrackets.AddDefaulted_GetRef();
+            Bracket.Start = BracketStart.Value;
+            Bracket.bExclusiveStart = BracketStart.bExclusive;
+            Bracket.Tags.AddTag(Emotion.Tag);
+            for (const FEmotionTriggerRange& RangeEmotion : Emotion.RangeEmotionTags)
+            {
+                if (RangeEmotion.EmotionTagTriggered.IsValid() && FBracketStart{ RangeEmotion.Start, false } <= BracketStart && BracketStart < FBracketStart{ RangeEmotion.End, true })
+                {
+                    Bracket.Tags.AddTag(RangeEmotion.EmotionTagTriggered);
+                }
+            }
+        }
+        Compiled.NumBrackets = CompiledBrackets.Num() - Compiled.FirstBracket;
+    }
+
+    // Link grids span the brackets of both emotions, so they are built once every emotion has its brackets
+    for (int32 EmotionIndex = 0; EmotionIndex < RuntimeEmotions.Num(); ++EmotionIndex)
+    {
+        const FEmotion& Emotion = RuntimeEmotions[EmotionIndex]->Emotion;
+        FEmotionCompiledEmotion& Compiled = CompiledEmotions[EmotionIndex];
+
+        Compiled.FirstLink = CompiledLinks.Num();
+        for (const FEmotionLink& Link : Emotion.LinkEmotions)
         {
-            float DistanceA = FVector2D::Distance(SourceEmotion->GetEmotionCoordinate(), A.GetEmotionCoordinate());
-            float DistanceB = FVector2D::Distance(SourceEmotion->GetEmotionCoordinate(), B.GetEmotionCoordinate());
-            return DistanceA < DistanceB;
-        });
+            if (!HasVariations(Link))
+            {
+                continue;
+            }
+
+            // Cells hold 1 + the index of the variation in 8 bits
+            const int32 NumVariations = FMath::Min(Link.VariationEmotionTags.Num(), int32(MAX_uint8) - 1);
+            if (NumVariations < Link.VariationEmotionTags.Num())
+            {
+                UE_LOG(LogTemp, Warning, TEXT("UEmotionLibrary::BuildCompiledEmotions - A link of %s in %s has more than %d variations, the rest are ignored"),
+                    *Emotion.Tag.ToString(), *GetName(), NumVariations);
+            }
+
+            FEmotionCompiledLink& CompiledLink = CompiledLinks.AddDefaulted_GetRef();
+            CompiledLink.LinkedIndex = FindLinkedIndex(Link);
+            CompiledLink.FirstVariation = CompiledLinkVariations.Num();
+            CompiledLink.FirstCell = CompiledLinkCells.Num();
+            CompiledLink.NumColumns = 1 + (CompiledLink.LinkedIndex != INDEX_NONE ? CompiledEmotions[CompiledLink.LinkedIndex].NumBrackets : 0);
+            for (int32 VariationIndex = 0; VariationIndex < NumVariations; ++VariationIndex)
+            {
+                CompiledLinkVariations.Add(Link.VariationEmotionTags[VariationIndex].EmotionTagTriggered);
+            }
+
+            // The first variation range containing a point wins, like FEmotionLink::GetEmotionTagTriggered
+            auto MakeCell = [&Link, NumVariations](TFunctionRef<bool(const FEmotionTriggerRange&)> Contains) -> uint8
+            {
+                for (int32 VariationIndex = 0; VariationIndex < NumVariations; ++VariationIndex)
+                {
+                    const FEmotionTriggerRange& Variation = Link.VariationEmotionTags[VariationIndex];
+                    if (Contains(Variation))
+                    {
+                        return Variation.EmotionTagTriggered.IsValid() ? static_cast<uint8>(VariationIndex + 1) : 0;
+                    }
+                }
+                return 0;
+            };
+
+            // An inactive linked emotion falls back to the link's threshold
+            const uint8 InactiveCell = MakeCell([&Link](const FEmotionTriggerRange& Variation) { return Variation.IsInRange(Link.Threshold); });
+
+            for (const FEmotionCompiledBracket& Row : MakeArrayView(CompiledBrackets.GetData() + Compiled.FirstBracket, Compiled.NumBrackets))
+            {
+                const bool bThresholdReached = FBracketStart{ Link.Threshold, false } <= FBracketStart{ Row.Start, Row.bExclusiveStart };
+                CompiledLinkCells.Add(bThresholdReached ? InactiveCell : 0);
+                for (int32 Column = 1; Column < CompiledLink.NumColumns; ++Column)
+                {
+                    const FEmotionCompiledBracket& LinkedBracket = CompiledBrackets[CompiledEmotions[CompiledLink.LinkedIndex].FirstBracket + Column - 1];
+                    const FBracketStart LinkedStart{ LinkedBracket.Start, LinkedBracket.bExclusiveStart };
+                    CompiledLinkCells.Add(bThresholdReached ? MakeCell([&LinkedStart](const FEmotionTriggerRange& Variation)
+                    {
+                        return FBracketStart{ Variation.Start, false } <= LinkedStart && LinkedStart < FBracketStart{ Variation.End, true };
+                    }) : 0);
+                }
+            }
+        }
+        Compiled.NumLinks = CompiledLinks.Num() - Compiled.FirstLink;
     }
-    
-    return Result;
+
+    // Neighbor queries range over the authored emotions, which come first
+    TArray<FVector2D> AuthoredCoordinates;
+    AuthoredCoordinates.Reserve(NumAuthoredRuntimeEmotions);
+    for (int32 EmotionIndex = 0; EmotionIndex < NumAuthoredRuntimeEmotions; ++EmotionIndex)
+    {
+        AuthoredCoordinates.Add(CompiledEmotions[EmotionIndex].Coordinate);
+    }
+    SpatialIndex.Build(AuthoredCoordinates);
 }
 
-UEmotionDefinition* UEmotionLibrary::GetCombinedEmotion(const FGameplayTag& EmotionTag1, const FGameplayTag& EmotionTag2) const
+void UEmotionLibrary::BuildZoneTable()
+{
+    // Core emotions around the wheel by angle, the first one wins for a tag
+    TArray<const UEmotionDefinition*> Cores;
+    for (const UEmotionDefinition* EmotionData : CoreEmotions)
+    {
+        if (EmotionData && EmotionData->Emotion.Tag.IsValid() && !Cores.ContainsByPredicate([EmotionData](const UEmotionDefinition* Core)
+        {
+            return Core->Emotion.Tag == EmotionData->Emotion.Tag;
+        }))
+        {
+            Cores.Add(EmotionData);
+        }
+    }
+    Algo::SortBy(Cores, [](const UEmotionDefinition* Core) { return UPolarCoordinateLibrary::NormalizeAngle(Core->Emotion.VACoordinate.Angle); });
+
+    TArray<FEmotionZone> CoreZones;
+    TArray<FEmotionZone> RangeZones;
+    TArray<FEmotionZone> VariationZones;
+    for (int32 CoreIndex = 0; CoreIndex < Cores.Num(); ++CoreIndex)
+    {
+        const FEmotion& Emotion = Cores[CoreIndex]->Emotion;
+        const float Angle = UPolarCoordinateLibrary::NormalizeAngle(Emotion.VACoordinate.Angle);
+
+        // Neighbors on the wheel, unwrapped around this core. A single core emotion covers the whole wheel.
+        const float PreviousAngle = CoreIndex > 0 ? UPolarCoordinateLibrary::NormalizeAngle(Cores[CoreIndex - 1]->Emotion.VACoordinate.Angle)
+            : UPolarCoordinateLibrary::NormalizeAngle(Cores.Last()->Emotion.VACoordinate.Angle) - 360.0f;
+        const float NextAngle = CoreIndex + 1 < Cores.Num() ? UPolarCoordinateLibrary::NormalizeAngle(Cores[CoreIndex + 1]->Emotion.VACoordinate.Angle)
+            : UPolarCoordinateLibrary::NormalizeAngle(Cores[0]->Emotion.VACoordinate.Angle) + 360.0f;
+        const float ConeStart = (PreviousAngle + Angle) * 0.5f;
+        const float ConeEnd = (Angle + NextAngle) * 0.5f;
+
+        FEmotionZone& CoreZone = CoreZones.AddDefaulted_GetRef();
+        CoreZone.EmotionTag = Emotion.Tag;
+        CoreZone.CoordinateRange.StartAngle = ConeStart;
+        CoreZone.CoordinateRange.EndAngle = ConeEnd;
+
+        // Intensity ranges are radius bands of the cone
+        for (const FEmotionTriggerRange& RangeEmotion : Emotion.RangeEmotionTags)
+        {
+            if (RangeEmotion.EmotionTagTriggered.IsValid())
+            {
+                FEmotionZone& RangeZone = RangeZones.AddDefaulted_GetRef();
+                RangeZone.EmotionTag = RangeEmotion.EmotionTagTriggered;
+                RangeZone.CoordinateRange = CoreZone.CoordinateRange;
+                RangeZone.CoordinateRange.MinRadius = FMath::Clamp(RangeEmotion.Start / 100.0f, 0.0f, 1.0f);
+                RangeZone.CoordinateRange.MaxRadius = FMath::Clamp(RangeEmotion.End / 100.0f, 0.0f, 1.0f);
+            }
+        }
+
+        // Each link owns the part of the cone leaning toward its linked emotion, from its threshold outward
+        struct FLinkDirection
+        {
+            float Offset;
+            float Threshold;
+            FGameplayTag VariationTag;
+        };
+        TArray<FLinkDirection> Links;
+        for (const FEmotionLink& Link : Emotion.LinkEmotions)
+        {
+            const FGameplayTag VariationTag = Link.GetEmotionTagTriggered();
+            const int32* LinkedIndex = Link.LinkEmotion.IsValid() ? RuntimeEmotionIndices.Find(Link.LinkEmotion) : nullptr;
+            if (VariationTag.IsValid() && LinkedIndex)
+            {
+                const float Offset = FMath::UnwindDegrees(RuntimeEmotions[*LinkedIndex]->Emotion.VACoordinate.Angle - Angle);
+                Links.Add({ Offset, Link.Threshold, VariationTag });
+            }
+        }
+        Algo::SortBy(Links, &FLinkDirection::Offset);
+
+        for (int32 LinkIndex = 0; LinkIndex < Links.Num(); ++LinkIndex)
+        {
+            FEmotionZone& VariationZone = VariationZones.AddDefaulted_GetRef();
+            VariationZone.EmotionTag = Links[LinkIndex].VariationTag;
+            VariationZone.CoordinateRange.MinRadius = FMath::Clamp(Links[LinkIndex].Threshold / 100.0f, 0.0f, 1.0f);
+            VariationZone.CoordinateRange.StartAngle = LinkIndex > 0
+                ? FMath::Clamp(Angle + (Links[LinkIndex - 1].Offset + Links[LinkIndex].Offset) * 0.5f, ConeStart, ConeEnd) : ConeStart;
+            VariationZone.CoordinateRange.EndAngle = LinkIndex + 1 < Links.Num()
+                ? FMath::Clamp(Angle + (Links[LinkIndex].Offset + Links[LinkIndex + 1].Offset) * 0.5f, ConeStart, ConeEnd) : ConeEnd;
+        }
+    }
+
+    ZoneTable.Build(CoreZones, RangeZones, VariationZones);
+}
+
+const FEmotionZoneTable& UEmotionLibrary::GetZoneTable() const
+{
+    EnsureRuntimeData();
+    return ZoneTable;
+}
+
+FEmotionZonePath UEmotionLibrary::GetEmotionZonePath(const FVector2D& VACoordinate) const
+{
+    return GetZoneTable().Classify(VACoordinate);
+}
+
+void UEmotionLibrary::GetEmotionZonePaths(TConstArrayView<FVector2D> VACoordinates, TArrayView<FEmotionZonePath> OutPaths) const
+{
+    GetZoneTable().ClassifyBatch(VACoordinates, OutPaths);
+}
+
+const FEmotionSpatialIndex& UEmotionLibrary::GetSpatialIndex() const
+{
+    EnsureRuntimeData();
+    return SpatialIndex;
+}
+
+TConstArrayView<FEmotionCompiledEmotion> UEmotionLibrary::GetCompiledEmotions() const
+{
+    EnsureRuntimeData();
+    return CompiledEmotions;
+}
+
+bool UEmotionLibrary::GetEmotionCoordinate(const FGameplayTag& EmotionTag, FVector2D& OutCoordinate) const
+{
+    const int32 EmotionIndex = FindEmotionIndex(EmotionTag);
+    if (EmotionIndex == INDEX_NONE)
+    {
+        return false;
+    }
+
+    OutCoordinate = CompiledEmotions[EmotionIndex].Coordinate;
+    return true;
+}
+
+UEmotionDefinition* UEmotionLibrary::FindClosestEmotion(const FVector2D& VACoordinate, bool bApproximate) const
+{
+    EnsureRuntimeData();
+
+    const int32 ClosestIndex = bApproximate ? SpatialIndex.FindNearestApproximate(VACoordinate) : SpatialIndex.FindNearest(VACoordinate);
+
+    return ClosestIndex != INDEX_NONE ? RuntimeEmotions[ClosestIndex] : nullptr;
+}
+
+void UEmotionLibrary::AppendTriggeredTags(TConstArrayView<int32> EmotionIndices, TConstArrayView<float> Intensities, FGameplayTagContainer& OutTags) const
+{
+    EnsureRuntimeData();
+    check(EmotionIndices.Num() == Intensities.Num());
+
+    // One bracket lookup per emotion, links read the brackets of both of their emotions
+    TArray<int32, TInlineAllocator<8>> Brackets;
+    for (int32 Index = 0; Index < EmotionIndices.Num(); ++Index)
+    {
+        Brackets.Add(FindIntensityBracket(EmotionIndices[Index], Intensities[Index]));
+    }
+
+    for (int32 Index = 0; Index < EmotionIndices.Num(); ++Index)
+    {
+        const int32 Bracket = Brackets[Index];
+        if (Bracket == INDEX_NONE)
+        {
+            continue;
+        }
+
+        const FEmotionCompiledEmotion& Compiled = CompiledEmotions[EmotionIndices[Index]];
+        OutTags.AppendTags(CompiledBrackets[Compiled.FirstBracket + Bracket].Tags);
+
+        for (const FEmotionCompiledLink& Link : MakeArrayView(CompiledLinks.GetData() + Compiled.FirstLink, Compiled.NumLinks))
+        {
+            const int32 LinkedEntry = Link.LinkedIndex != INDEX_NONE ? EmotionIndices.Find(Link.LinkedIndex) : INDEX_NONE;
+            const int32 Column = LinkedEntry != INDEX_NONE ? 1 + Brackets[LinkedEntry] : 0;
+            const uint8 Cell = CompiledLinkCells[Link.FirstCell + Bracket * Link.NumColumns + Column];
+            if (Cell != 0)
+            {
+                OutTags.AddTag(CompiledLinkVariations[Link.FirstVariation + Cell - 1]);
+            }
+        }
+    }
+}
+
+void UEmotionLibrary::AppendTriggeredTags(int32 EmotionIndex, float Intensity, FGameplayTagContainer& OutTags) const
+{
+    AppendTriggeredTags(MakeArrayView(&EmotionIndex, 1), MakeArrayView(&Intensity, 1), OutTags);
+}
+
+int32 UEmotionLibrary::FindIntensityBracket(int32 EmotionIndex, float Intensity) const
+{
+    EnsureRuntimeData();
+    if (!CompiledEmotions.IsValidIndex(EmotionIndex))
+    {
+        return INDEX_NONE;
+    }
+
+    // A handful of brackets per emotion, the first one also takes intensities below its start
+    const FEmotionCompiledEmotion& Compiled = CompiledEmotions[EmotionIndex];
+    int32 Bracket = Compiled.NumBrackets - 1;
+    while (Bracket > 0 && !CompiledBrackets[Compiled.FirstBracket + Bracket].IsReachedBy(Intensity))
+    {
+        --Bracket;
+    }
+    return Bracket;
+}
+
+const FGameplayTagContainer& UEmotionLibrary::GetBracketTags(int32 EmotionIndex, int32 Bracket) const
+{
+    EnsureRuntimeData();
+    if (!CompiledEmotions.IsValidIndex(EmotionIndex) || Bracket < 0 || Bracket >= CompiledEmotions[EmotionIndex].NumBrackets)
+    {
+        return FGameplayTagContainer::EmptyContainer;
+    }
+
+    return CompiledBrackets[CompiledEmotions[EmotionIndex].FirstBracket + Bracket].Tags;
+}
+
+TConstArrayView<UEmotionDefinition*> UEmotionLibrary::GetRuntimeEmotions() const
+{
+    EnsureRuntimeData();
+    return RuntimeEmotions;
+}
+
+TConstArrayView<FGameplayTag> UEmotionLibrary::GetRuntimeEmotionTags() const
 {
-    // Check all combination mappings
+    EnsureRuntimeData();
+    return RuntimeEmotionTags;
+}
+
+int32 UEmotionLibrary::FindEmotionIndex(const FGameplayTag& EmotionTag) const
+{
+    EnsureRuntimeData();
+    const int32* EmotionIndex = RuntimeEmotionIndices.Find(EmotionTag);
+    return EmotionIndex ? *EmotionIndex : INDEX_NONE;
+}
+
+UEmotionDefinition* UEmotionLibrary::GetEmotionByIndex(int32 EmotionIndex) const
+{
+    EnsureRuntimeData();
+    return RuntimeEmotions.IsValidIndex(EmotionIndex) ? RuntimeEmotions[EmotionIndex] : nullptr;
+}
+
+void UEmotionLibrary::GatherReferencedTags(TArray<FGameplayTag>& OutTags) const
+{
+    auto GatherEmotion = [&OutTags](const UEmotionDefinition* EmotionData)
+    {
+        if (!EmotionData)
+        {
+            return;
+        }
+
+        const FEmotion& Emotion = EmotionData->Emotion;
+        OutTags.Add(Emotion.Tag);
+        OutTags.Add(Emotion.OppositeEmotionTag);
+        for (const FEmotionTriggerRange& RangeEmotion : Emotion.RangeEmotionTags)
+        {
+            OutTags.Add(RangeEmotion.EmotionTagTriggered);
+        }
+        for (const FEmotionLink& Link : Emotion.LinkEmotions)
+        {
+            OutTags.Add(Link.LinkEmotion);
+            for (const FEmotionTriggerRange& Variation : Link.VariationEmotionTags)
+            {
+                OutTags.Add(Variation.EmotionTagTriggered);
+            }
+        }
+    };
+
+    for (const UEmotionDefinition* EmotionData : Emotions)
+    {
+        GatherEmotion(EmotionData);
+    }
+    for (const UEmotionDefinition* EmotionData : CoreEmotions)
+    {
+        GatherEmotion(EmotionData);
+    }
     for (const UCombinedEmotionMapping* Mapping : CombineEmotions)
     {
         if (Mapping)
         {
             for (const FCombineEmotionMapping& CombineMapping : Mapping->CombinedEmotions)
             {
-                // Create a container with the two emotion tags
-                FGameplayTagContainer TestContainer;
-                TestContainer.AddTag(EmotionTag1);
-                TestContainer.AddTag(EmotionTag2);
-                
-                // Check if this combination matches the mapping
-                if (TestContainer.HasAll(CombineMapping.TriggerEmotions) && 
-                    TestContainer.Num() == CombineMapping.TriggerEmotions.Num())
-                {
-                    return CombineMapping.ResultEmotion;
-                }
+                OutTags.Append(CombineMapping.TriggerEmotions.GetGameplayTagArray());
+                GatherEmotion(CombineMapping.ResultEmotion);
             }
         }
     }
+}
+
+const FEmotionTagSpace& UEmotionLibrary::GetTagSpace() const
+{
+    EnsureRuntimeData();
+    return TagSpace;
+}
+
+uint32 UEmotionLibrary::GetCompileId() const
+{
+    EnsureRuntimeData();
+    return CompileId;
+}
+
+const FEmotionCombinationTable& UEmotionLibrary::GetCombinationTable() const
+{
+    EnsureRuntimeData();
+    return CombinationTable;
+}
+
+// FEmotionTriggerSetKey implementation
+FEmotionTriggerSetKey::FEmotionTriggerSetKey(TConstArrayView<FGameplayTag> InTags)
+{
+    for (const FGameplayTag& Tag : InTags)
+    {
+        if (Tag.IsValid())
+        {
+            Tags.Add(Tag);
+        }
+    }
+
+    // Any fixed order works, the name index is the cheapest to compare
+    Tags.Sort([](const FGameplayTag& A, const FGameplayTag& B) { return A.GetTagName().FastLess(B.GetTagName()); });
+    Tags.SetNum(Algo::Unique(Tags));
+}
+
+// FEmotionCombinationTable implementation
+void FEmotionCombinationTable::Reset()
+{
+    Combinations.Reset();
+    AffectedCombinations.Reset();
+    CombinationsByTriggers.Reset();
+    bHasParentTriggers = false;
+}
+
+SIZE_T FEmotionCombinationTable::GetAllocatedSize() const
+{
+    SIZE_T Size = Combinations.GetAllocatedSize() + AffectedCombinations.GetAllocatedSize() + CombinationsByTriggers.GetAllocatedSize();
+    for (const FEmotionCompiledCombination& Combination : Combinations)
+    {
+        Size += Combination.TriggerTags.GetAllocatedSize();
+    }
+    for (const TPair<FGameplayTag, TArray<int32>>& Affected : AffectedCombinations)
+    {
+        Size += Affected.Value.GetAllocatedSize();
+    }
+    for (const TPair<FEmotionTriggerSetKey, int32>& Triggers : CombinationsByTriggers)
+    {
+        Size += Triggers.Key.Tags.GetAllocatedSize();
+    }
+    return Size;
+}
+
+int32 FEmotionCombinationTable::FindCombination(TConstArrayView<FGameplayTag> EmotionTags) const
+{
+    const FEmotionTriggerSetKey Key(EmotionTags);
+    if (Key.Tags.Num() == 0)
+    {
+        return INDEX_NONE;
+    }
+
+    if (const int32* CombinationIndex = CombinationsByTriggers.Find(Key))
+    {
+        return *CombinationIndex;
+    }
+
+    if (!bHasParentTriggers)
+    {
+        return INDEX_NONE;
+    }
+
+    // A trigger naming a parent tag is met by its children: retry with each tag replaced by itself or one of its
+    // parents, most specific first. Sets collapsing to fewer tags are skipped, the trigger count must match.
+    TArray<TArray<FGameplayTag, TInlineAllocator<4>>, TInlineAllocator<4>> Candidates;
+    for (const FGameplayTag& Tag : Key.Tags)
+    {
+        TArray<FGameplayTag, TInlineAllocator<4>>& TagCandidates = Candidates.AddDefaulted_GetRef();
+        for (FGameplayTag Candidate = Tag; Candidate.IsValid(); Candidate = Candidate.RequestDirectParent())
+        {
+            TagCandidates.Add(Candidate);
+        }
+    }
+
+    TArray<int32, TInlineAllocator<4>> Choices;
+    Choices.SetNumZeroed(Candidates.Num());
+    TArray<FGameplayTag, TInlineAllocator<4>> Tags;
+    while (true)
+    {
+        // Advance like an odometer, the all-specific set was probed above
+        int32 Position = 0;
+        while (Position < Choices.Num() && ++Choices[Position] == Candidates[Position].Num())
+        {
+            Choices[Position++] = 0;
+        }
+        if (Position == Choices.Num())
+        {
+            return INDEX_NONE;
+        }
+
+        Tags.Reset();
+        for (int32 TagIndex = 0; TagIndex < Choices.Num(); ++TagIndex)
+        {
+            Tags.Add(Candidates[TagIndex][Choices[TagIndex]]);
+        }
+
+        const FEmotionTriggerSetKey ParentKey(Tags);
+        if (ParentKey.Tags.Num() == Key.Tags.Num())
+        {
+            if (const int32* CombinationIndex = CombinationsByTriggers.Find(ParentKey))
+            {
+                return *CombinationIndex;
+            }
+        }
+    }
+}
+
+void FEmotionCombinationTable::Build(const TArray<TObjectPtr<UCombinedEmotionMapping>>& Mappings, TConstArrayView<UEmotionDefinition*> RuntimeEmotions, const FEmotionTagSpace& TagSpace)
+{
+    Reset();
+
+    for (const UCombinedEmotionMapping* Mapping : Mappings)
+    {
+        if (!Mapping)
+        {
+            continue;
+        }
+
+        for (const FCombineEmotionMapping& CombineMapping : Mapping->CombinedEmotions)
+        {
+            // Results sharing a tag with another emotion resolve to the emotion that owns the tag
+            const UEmotionDefinition* ResultEmotion = CombineMapping.ResultEmotion;
+            const int32 ResultEmotionIndex = ResultEmotion ? RuntimeEmotions.IndexOfByPredicate([ResultEmotion](const UEmotionDefinition* EmotionData)
+            {
+                return EmotionData->Emotion.Tag == ResultEmotion->Emotion.Tag;
+            }) : INDEX_NONE;
+            if (CombineMapping.TriggerEmotions.IsEmpty() || ResultEmotionIndex == INDEX_NONE)
+            {
+                continue;
+            }
+
+            FEmotionCompiledCombination& Combination = Combinations.AddDefaulted_GetRef();
+            Combination.TriggerTags = CombineMapping.TriggerEmotions.GetGameplayTagArray();
+            Combination.ResultEmotionIndex = ResultEmotionIndex;
+            Combination.ResultTag = CombineMapping.ResultEmotion->Emotion.Tag;
+
+            bool bComplete = false;
+            Combination.TriggerMask = TagSpace.MakeQueryMask(CombineMapping.TriggerEmotions, bComplete);
+        }
+    }
+
+    // Index every combination under each emotion that can satisfy one of its triggers or that it produces
+    auto IndexEmotion = [this](const FGameplayTag& EmotionTag)
+    {
+        if (AffectedCombinations.Contains(EmotionTag))
+        {
+            return;
+        }
+
+        TArray<int32> Affected;
+        for (int32 Index = 0; Index < Combinations.Num(); ++Index)
+        {
+            const FEmotionCompiledCombination& Combination = Combinations[Index];
+            const bool bIsTrigger = Combination.TriggerTags.ContainsByPredicate([&EmotionTag](const FGameplayTag& TriggerTag)
+            {
+                return EmotionTag.MatchesTag(TriggerTag);
+            });
+
+            if (bIsTrigger || Combination.ResultTag == EmotionTag)
+            {
+                Affected.Add(Index);
+            }
+        }
+
+        if (Affected.Num() > 0)
+        {
+            AffectedCombinations.Add(EmotionTag, MoveTemp(Affected));
+        }
+    };
+
+    for (const UEmotionDefinition* EmotionData : RuntimeEmotions)
+    {
+        IndexEmotion(EmotionData->Emotion.Tag);
+    }
+
+    // Lookups by trigger set, the first mapping with a set keeps it like the scan this replaces
+    for (int32 Index = 0; Index < Combinations.Num(); ++Index)
+    {
+        const FEmotionCompiledCombination& Combination = Combinations[Index];
+        CombinationsByTriggers.FindOrAdd(FEmotionTriggerSetKey(Combination.TriggerTags), Index);
+
+        for (const FGameplayTag& TriggerTag : Combination.TriggerTags)
+        {
+            bHasParentTriggers = bHasParentTriggers || RuntimeEmotions.ContainsByPredicate([&TriggerTag](const UEmotionDefinition* EmotionData)
+            {
+                return EmotionData->Emotion.Tag != TriggerTag && EmotionData->Emotion.Tag.MatchesTag(TriggerTag);
+            });
+        }
+    }
+}
+
+UEmotionDefinition* UEmotionLibrary::GetEmotionByTag(const FGameplayTag& EmotionTag) const
+{
+    return GetEmotionByIndex(FindEmotionIndex(EmotionTag));
+}
+
+TArray<UEmotionDefinition*> UEmotionLibrary::GetOppositeEmotions(const FGameplayTag& EmotionTag) const
+{
+    TArray<UEmotionDefinition*> Result;
     
-    return nullptr;
+    // Get the direct opposite
+    const int32 EmotionIndex = FindEmotionIndex(EmotionTag);
+    if (EmotionIndex != INDEX_NONE && CompiledEmotions[EmotionIndex].OppositeIndex != INDEX_NONE)
+    {
+        Result.Add(RuntimeEmotions[CompiledEmotions[EmotionIndex].OppositeIndex]);
+    }
+    
+    return Result;
 }
 
-TArray<UEmotionDefinition*> UEmotionLibrary::FindEmotionsInRadius(const FVector2D& VACoordinate, float Radius) const
+FVector2D UEmotionDefinition::GetEmotionCoordinate() const
+{
+	return Emotion.VACoordinate.GetCartesianCoordinate();
+}
+
+TArray<UEmotionDefinition*> UEmotionLibrary::GetAdjacentEmotions(const FGameplayTag& EmotionTag, float MaxDistance) const
 {
     TArray<UEmotionDefinition*> Result;
+    const int32 SourceIndex = FindEmotionIndex(EmotionTag);
     
-    // Find all emotions within the specified radius in VA space
-    for (UEmotionDefinition* EmotionData : Emotions)
+    if (SourceIndex != INDEX_NONE)
     {
-        if (EmotionData)
+        // Authored emotions read their precomputed neighbors (closest first), combination results query the grid
+        TArray<FEmotionNeighbor> Neighbors;
+        if (SourceIndex < SpatialIndex.Num())
         {
-            // Calculate distance in VA space
-            float Distance = FVector2D::Distance(VACoordinate, EmotionData->GetEmotionCoordinate());
-            
-            // Add to result if within the specified radius
-            if (Distance <= Radius)
-            {
-                Result.Add(EmotionData);
-            }
+            SpatialIndex.FindAdjacent(SourceIndex, MaxDistance, Neighbors);
+        }
+        else
+        {
+            SpatialIndex.FindInRadius(CompiledEmotions[SourceIndex].Coordinate, MaxDistance, Neighbors);
+        }
+        
+        Result.Reserve(Neighbors.Num());
+        for (const FEmotionNeighbor& Neighbor : Neighbors)
+        {
+            Result.Add(RuntimeEmotions[Neighbor.EmotionIndex]);
         }
     }
     
-    // Sort by distance (closest first)
-    Result.Sort([VACoordinate](const UEmotionDefinition& A, const UEmotionDefinition& B)
+    return Result;
+}
+
+UEmotionDefinition* UEmotionLibrary::GetCombinedEmotion(const FGameplayTag& EmotionTag1, const FGameplayTag& EmotionTag2) const
+{
+    const FGameplayTag EmotionTags[] = { EmotionTag1, EmotionTag2 };
+    return GetCombinedEmotionForTags(EmotionTags);
+}
+
+UEmotionDefinition* UEmotionLibrary::GetCombinedEmotionForTags(const FGameplayTagContainer& EmotionTags) const
+{
+    return GetCombinedEmotionForTags(EmotionTags.GetGameplayTagArray());
+}
+
+UEmotionDefinition* UEmotionLibrary::GetCombinedEmotionForTags(TConstArrayView<FGameplayTag> EmotionTags) const
+{
+    EnsureRuntimeData();
+    
+    // Precompiled trigger sets, the first mapping with the set wins
+    const int32 CombinationIndex = CombinationTable.FindCombination(EmotionTags);
+    return CombinationIndex != INDEX_NONE ? RuntimeEmotions[CombinationTable.Combinations[CombinationIndex].ResultEmotionIndex] : nullptr;
+}
+
+TArray<UEmotionDefinition*> UEmotionLibrary::FindEmotionsInRadius(const FVector2D& VACoordinate, float Radius) const
+{
+    TArray<UEmotionDefinition*> Result;
+    EnsureRuntimeData();
+    
+    // Find all emotions within the specified radius in VA space, closest first
+    TArray<FEmotionNeighbor> Neighbors;
+    SpatialIndex.FindInRadius(VACoordinate, Radius, Neighbors);
+    
+    Result.Reserve(Neighbors.Num());
+    for (const FEmotionNeighbor& Neighbor : Neighbors)
     {
-        float DistanceA = FVector2D::Distance(VACoordinate, A.GetEmotionCoordinate());
-        float DistanceB = FVector2D::Distance(VACoordinate, B.GetEmotionCoordinate());
-        return DistanceA < DistanceB;
-    });
+        Result.Add(RuntimeEmotions[Neighbor.EmotionIndex]);
+    }
     
     return Result;
 }
@@ -1,12 +1,33 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "EmotionEngine.h"
+#include "EmotionData.h"
+#if WITH_EDITOR
+#include "UObject/ICookInfo.h"
+#endif
 
 #define LOCTEXT_NAMESPACE "FEmotionEngineModule"
 
+DEFINE_STAT(STAT_EmotionLibraryMemory);
+DEFINE_STAT(STAT_EmotionAgentStateMemory);
+DEFINE_STAT(STAT_EmotionIndexMemory);
+DEFINE_STAT(STAT_EmotionQueueMemory);
+DEFINE_STAT(STAT_EmotionTagSetMemory);
+DEFINE_STAT(STAT_EmotionAgents);
+DEFINE_STAT(STAT_EmotionPooledStates);
+
+LLM_DEFINE_TAG(EmotionEngine);
+
 void FEmotionEngineModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+#if WITH_EDITOR
+	// One summary of the presentation data left out of server platforms per cook
+	UE::Cook::FDelegates::CookByTheBookFinished.AddStatic([](UE::Cook::ICookInfo& CookInfo)
+	{
+		UEmotionDefinition::ReportStrippedPresentationData();
+	});
+#endif
 }
 
 void FEmotionEngineModule::ShutdownModule()
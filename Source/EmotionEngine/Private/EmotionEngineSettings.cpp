@@ -0,0 +1,7 @@
+#include "EmotionEngineSettings.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(EmotionEngineSettings)
+
+UEmotionEngineSettings::UEmotionEngineSettings()
+    : bStripPresentationDataForServer(true)
+{}
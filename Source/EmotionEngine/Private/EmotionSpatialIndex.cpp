@@ -0,0 +1,301 @@
+#include "EmotionSpatialIndex.h"
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+
+void FEmotionSpatialIndex::Build(TConstArrayView<FVector2D> InCoordinates)
+{
+    Reset();
+    if (InCoordinates.Num() == 0)
+    {
+        return;
+    }
+
+    Coordinates.Append(InCoordinates.GetData(), InCoordinates.Num());
+
+    FBox2D Bounds(ForceInit);
+    for (const FVector2D& Coordinate : Coordinates)
+    {
+        Bounds += Coordinate;
+    }
+
+    // Cells about as wide as the common query radius, a query at that radius visits at most 3x3 cells
+    const FVector2D Extent = Bounds.GetSize();
+    const double CellSize = FMath::Max3<double>(AdjacencyRadius, Extent.X / MaxCellsPerAxis, Extent.Y / MaxCellsPerAxis);
+    GridOrigin = Bounds.Min;
+    InvCellSize = 1.0 / CellSize;
+    CellsX = FMath::Clamp(FMath::FloorToInt32(Extent.X * InvCellSize) + 1, 1, MaxCellsPerAxis);
+    CellsY = FMath::Clamp(FMath::FloorToInt32(Extent.Y * InvCellSize) + 1, 1, MaxCellsPerAxis);
+
+    // Counting sort of the emotions into their cells
+    TArray<int32> EmotionCells;
+    EmotionCells.SetNumUninitialized(Coordinates.Num());
+    CellStarts.SetNumZeroed(CellsX * CellsY + 1);
+    for (int32 EmotionIndex = 0; EmotionIndex < Coordinates.Num(); ++EmotionIndex)
+    {
+        const FVector2D& Coordinate = Coordinates[EmotionIndex];
+        EmotionCells[EmotionIndex] = GetCellY(Coordinate.Y) * CellsX + GetCellX(Coordinate.X);
+        ++CellStarts[EmotionCells[EmotionIndex] + 1];
+    }
+    for (int32 CellIndex = 1; CellIndex < CellStarts.Num(); ++CellIndex)
+    {
+        CellStarts[CellIndex] += CellStarts[CellIndex - 1];
+    }
+
+    TArray<int32> CellFill(CellStarts.GetData(), CellStarts.Num() - 1);
+    CellEntries.SetNumUninitialized(Coordinates.Num());
+    for (int32 EmotionIndex = 0; EmotionIndex < Coordinates.Num(); ++EmotionIndex)
+    {
+        CellEntries[CellFill[EmotionCells[EmotionIndex]]++] = EmotionIndex;
+    }
+
+    // Neighbor graph from the grid, each list sorted once here instead of on every query
+    TArray<FEmotionNeighbor> Found;
+    NeighborStarts.Reserve(Coordinates.Num() + 1);
+    NeighborStarts.Add(0);
+    for (int32 EmotionIndex = 0; EmotionIndex < Coordinates.Num(); ++EmotionIndex)
+    {
+        FindInRadius(Coordinates[EmotionIndex], AdjacencyRadius, Found);
+        for (const FEmotionNeighbor& Neighbor : Found)
+        {
+            if (Neighbor.EmotionIndex != EmotionIndex)
+            {
+                Neighbors.Add(Neighbor);
+            }
+        }
+        NeighborStarts.Add(Neighbors.Num());
+    }
+    Neighbors.Shrink();
+
+    if (Coordinates.Num() >= MinEmotionsForNearestGrid)
+    {
+        BuildNearestGrid(Bounds);
+    }
+}
+
+void FEmotionSpatialIndex::BuildNearestGrid(const FBox2D& Bounds)
+{
+    FBox2D GridBounds = Bounds;
+    GridBounds += FVector2D(-1.0, -1.0);
+    GridBounds += FVector2D(1.0, 1.0);
+
+    const double CellSize = FMath::Max(GridBounds.GetSize().GetMax() / NearestGridResolution, UE_KINDA_SMALL_NUMBER);
+    NearestGridOrigin = GridBounds.Min;
+    NearestInvCellSize = 1.0 / CellSize;
+
+    // Every point of a cell is within half a diagonal of its center, so the nearest emotion of any point in the cell
+    // is at most the center's nearest distance plus a full diagonal away from the center
+    const double CandidateMargin = CellSize * UE_SQRT_2 + UE_KINDA_SMALL_NUMBER;
+
+    // Rows are built in parallel with row-local candidate runs, merged below
+    TArray<TArray<uint16>> RowCandidates;
+    RowCandidates.SetNum(NearestGridResolution);
+    NearestCells.SetNumUninitialized(NearestGridResolution * NearestGridResolution);
+
+    ParallelFor(NearestGridResolution, [this, CellSize, CandidateMargin, &RowCandidates](int32 Row)
+    {
+        TArray<uint16>& Runs = RowCandidates[Row];
+        for (int32 Column = 0; Column < NearestGridResolution; ++Column)
+        {
+            const FVector2D Center = NearestGridOrigin + FVector2D(Column + 0.5, Row + 0.5) * CellSize;
+            const int32 NearestIndex = FindNearestBruteForce(Center);
+            const double CandidateDistanceSquared = FMath::Square(FVector2D::Distance(Center, Coordinates[NearestIndex]) + CandidateMargin);
+
+            const int32 RunStart = Runs.Num();
+            Runs.Add(0);
+            Runs.Add(static_cast<uint16>(NearestIndex));
+            for (int32 EmotionIndex = 0; EmotionIndex < Coordinates.Num(); ++EmotionIndex)
+            {
+                if (FVector2D::DistSquared(Center, Coordinates[EmotionIndex]) <= CandidateDistanceSquared)
+                {
+                    Runs.Add(static_cast<uint16>(EmotionIndex));
+                }
+            }
+
+            uint32& Cell = NearestCells[Row * NearestGridResolution + Column];
+            const int32 NumCandidates = Runs.Num() - RunStart - 2;
+            if (NumCandidates == 1)
+            {
+                // The same emotion is nearest everywhere in the cell
+                Runs.SetNum(RunStart, EAllowShrinking::No);
+                Cell = static_cast<uint32>(NearestIndex);
+            }
+            else
+            {
+                Runs[RunStart] = static_cast<uint16>(NumCandidates);
+                Cell = AmbiguousCellFlag | static_cast<uint32>(RunStart);
+            }
+        }
+    });
+
+    for (int32 Row = 0; Row < NearestGridResolution; ++Row)
+    {
+        const uint32 RowOffset = static_cast<uint32>(NearestCandidates.Num());
+        NearestCandidates.Append(RowCandidates[Row]);
+        for (uint32& Cell : MakeArrayView(NearestCells.GetData() + Row * NearestGridResolution, NearestGridResolution))
+        {
+            if (Cell & AmbiguousCellFlag)
+            {
+                Cell += RowOffset;
+            }
+        }
+    }
+}
+
+void FEmotionSpatialIndex::Reset()
+{
+    Coordinates.Reset();
+    CellStarts.Reset();
+    CellEntries.Reset();
+    NeighborStarts.Reset();
+    Neighbors.Reset();
+    NearestCells.Reset();
+    NearestCandidates.Reset();
+    CellsX = 0;
+    CellsY = 0;
+}
+
+void FEmotionSpatialIndex::FindInRadius(const FVector2D& Center, float Radius, TArray<FEmotionNeighbor>& OutNeighbors) const
+{
+    OutNeighbors.Reset();
+    if (Coordinates.Num() == 0 || Radius < 0.0f)
+    {
+        return;
+    }
+
+    // Cells overlapping the bounding square of the query circle
+    const int32 MinX = GetCellX(Center.X - Radius);
+    const int32 MaxX = GetCellX(Center.X + Radius);
+    const int32 MinY = GetCellY(Center.Y - Radius);
+    const int32 MaxY = GetCellY(Center.Y + Radius);
+    const float RadiusSquared = FMath::Square(Radius);
+
+    for (int32 CellY = MinY; CellY <= MaxY; ++CellY)
+    {
+        // Cells of a row are contiguous, visit them as one range
+        const int32 RowStart = CellY * CellsX;
+        for (int32 EntryIndex = CellStarts[RowStart + MinX]; EntryIndex < CellStarts[RowStart + MaxX + 1]; ++EntryIndex)
+        {
+            const int32 EmotionIndex = CellEntries[EntryIndex];
+            const float DistanceSquared = FVector2D::DistSquared(Center, Coordinates[EmotionIndex]);
+            if (DistanceSquared <= RadiusSquared)
+            {
+                OutNeighbors.Emplace(DistanceSquared, EmotionIndex);
+            }
+        }
+    }
+
+    // Only the hits are sorted, distances were computed once each
+    OutNeighbors.Sort();
+}
+
+void FEmotionSpatialIndex::FindAdjacent(int32 EmotionIndex, float MaxDistance, TArray<FEmotionNeighbor>& OutNeighbors) const
+{
+    OutNeighbors.Reset();
+    if (!Coordinates.IsValidIndex(EmotionIndex))
+    {
+        return;
+    }
+
+    if (MaxDistance <= AdjacencyRadius)
+    {
+        // Prefix of the precomputed list
+        const TConstArrayView<FEmotionNeighbor> EmotionNeighbors = GetNeighbors(EmotionIndex);
+        const float MaxDistanceSquared = FMath::Square(MaxDistance);
+        const int32 NumWithin = Algo::UpperBoundBy(EmotionNeighbors, MaxDistanceSquared, &FEmotionNeighbor::DistanceSquared);
+        OutNeighbors.Append(EmotionNeighbors.GetData(), NumWithin);
+        return;
+    }
+
+    FindInRadius(Coordinates[EmotionIndex], MaxDistance, OutNeighbors);
+    OutNeighbors.RemoveAll([EmotionIndex](const FEmotionNeighbor& Neighbor) { return Neighbor.EmotionIndex == EmotionIndex; });
+}
+
+TConstArrayView<FEmotionNeighbor> FEmotionSpatialIndex::GetNeighbors(int32 EmotionIndex) const
+{
+    if (!Coordinates.IsValidIndex(EmotionIndex))
+    {
+        return TConstArrayView<FEmotionNeighbor>();
+    }
+
+    return MakeArrayView(Neighbors.GetData() + NeighborStarts[EmotionIndex], NeighborStarts[EmotionIndex + 1] - NeighborStarts[EmotionIndex]);
+}
+
+bool FEmotionSpatialIndex::GetNearestCell(const FVector2D& Point, int32& OutCell) const
+{
+    const int32 Column = FMath::FloorToInt32((Point.X - NearestGridOrigin.X) * NearestInvCellSize);
+    const int32 Row = FMath::FloorToInt32((Point.Y - NearestGridOrigin.Y) * NearestInvCellSize);
+    if (Column < 0 || Column >= NearestGridResolution || Row < 0 || Row >= NearestGridResolution)
+    {
+        return false;
+    }
+
+    OutCell = Row * NearestGridResolution + Column;
+    return true;
+}
+
+int32 FEmotionSpatialIndex::FindNearest(const FVector2D& Point) const
+{
+    int32 CellIndex;
+    if (!HasNearestGrid() || !GetNearestCell(Point, CellIndex))
+    {
+        return FindNearestBruteForce(Point);
+    }
+
+    const uint32 Cell = NearestCells[CellIndex];
+    if (!(Cell & AmbiguousCellFlag))
+    {
+        return static_cast<int32>(Cell);
+    }
+
+    // Only the emotions that can be nearest somewhere in the cell, in index order so ties resolve like the scan
+    const uint16* Run = NearestCandidates.GetData() + (Cell & ~AmbiguousCellFlag);
+    int32 NearestIndex = INDEX_NONE;
+    float NearestDistanceSquared = MAX_FLT;
+    for (const uint16 EmotionIndex : MakeArrayView(Run + 2, Run[0]))
+    {
+        const float DistanceSquared = FVector2D::DistSquared(Point, Coordinates[EmotionIndex]);
+        if (DistanceSquared < NearestDistanceSquared)
+        {
+            NearestDistanceSquared = DistanceSquared;
+            NearestIndex = EmotionIndex;
+        }
+    }
+    return NearestIndex;
+}
+
+int32 FEmotionSpatialIndex::FindNearestApproximate(const FVector2D& Point) const
+{
+    if (!HasNearestGrid())
+    {
+        return FindNearestBruteForce(Point);
+    }
+
+    // Points outside the grid use the closest border cell
+    const int32 Column = FMath::Clamp(FMath::FloorToInt32((Point.X - NearestGridOrigin.X) * NearestInvCellSize), 0, NearestGridResolution - 1);
+    const int32 Row = FMath::Clamp(FMath::FloorToInt32((Point.Y - NearestGridOrigin.Y) * NearestInvCellSize), 0, NearestGridResolution - 1);
+    const uint32 Cell = NearestCells[Row * NearestGridResolution + Column];
+    return Cell & AmbiguousCellFlag ? NearestCandidates[(Cell & ~AmbiguousCellFlag) + 1] : static_cast<int32>(Cell);
+}
+
+int32 FEmotionSpatialIndex::FindNearestBruteForce(const FVector2D& Point) const
+{
+    int32 NearestIndex = INDEX_NONE;
+    float NearestDistanceSquared = MAX_FLT;
+    for (int32 EmotionIndex = 0; EmotionIndex < Coordinates.Num(); ++EmotionIndex)
+    {
+        const float DistanceSquared = FVector2D::DistSquared(Point, Coordinates[EmotionIndex]);
+        if (DistanceSquared < NearestDistanceSquared)
+        {
+            NearestDistanceSquared = DistanceSquared;
+            NearestIndex = EmotionIndex;
+        }
+    }
+    return NearestIndex;
+}
+
+SIZE_T FEmotionSpatialIndex::GetAllocatedSize() const
+{
+    return Coordinates.GetAllocatedSize() + CellStarts.GetAllocatedSize() + CellEntries.GetAllocatedSize()
+        + NeighborStarts.GetAllocatedSize() + Neighbors.GetAllocatedSize()
+        + NearestCells.GetAllocatedSize() + NearestCandidates.GetAllocatedSize();
+}
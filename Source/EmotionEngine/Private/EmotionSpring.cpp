@@ -0,0 +1,35 @@
+#include "EmotionSpring.h"
+
+void FEmotionSpring::StepBatch(
+    TArrayView<float> PositionX, TArrayView<float> PositionY,
+    TArrayView<float> VelocityX, TArrayView<float> VelocityY,
+    TConstArrayView<float> TargetX, TConstArrayView<float> TargetY,
+    TConstArrayView<float> Stiffness, TConstArrayView<float> Damping,
+    float DeltaTime)
+{
+    const int32 Num = PositionX.Num();
+    check(PositionY.Num() == Num && VelocityX.Num() == Num && VelocityY.Num() == Num);
+    check(TargetX.Num() == Num && TargetY.Num() == Num && Stiffness.Num() == Num && Damping.Num() == Num);
+
+    float* RESTRICT PX = PositionX.GetData();
+    float* RESTRICT PY = PositionY.GetData();
+    float* RESTRICT VX = VelocityX.GetData();
+    float* RESTRICT VY = VelocityY.GetData();
+    const float* RESTRICT TX = TargetX.GetData();
+    const float* RESTRICT TY = TargetY.GetData();
+    const float* RESTRICT K = Stiffness.GetData();
+    const float* RESTRICT C = Damping.GetData();
+    const float DeltaTimeSq = DeltaTime * DeltaTime;
+
+    for (int32 Index = 0; Index < Num; ++Index)
+    {
+        const float SpringTerm = DeltaTime * K[Index];
+        const float InvDenominator = 1.0f / (1.0f + DeltaTime * C[Index] + DeltaTimeSq * K[Index]);
+
+        VX[Index] = (VX[Index] - (PX[Index] - TX[Index]) * SpringTerm) * InvDenominator;
+        VY[Index] = (VY[Index] - (PY[Index] - TY[Index]) * SpringTerm) * InvDenominator;
+
+        PX[Index] += VX[Index] * DeltaTime;
+        PY[Index] += VY[Index] * DeltaTime;
+    }
+}
@@ -0,0 +1,723 @@
+#include "EmotionStateData.h"
+#include "EmotionData.h"
+#include "EmotionSpring.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(EmotionStateData)
+
+FEmotionStateData::FEmotionStateData()
+    : InfluenceRadius(0.3f)
+    , SpringStiffness(2.0f)
+    , DampingFactor(0.5f)
+    , EmotionLibrary(nullptr)
+{}
+
+void FEmotionStateData::Initialize(UEmotionLibrary* InEmotionLibrary)
+{
+    EmotionLibrary = InEmotionLibrary;
+    EmotionTagSet.Reset();
+    ActiveEmotions.Reset();
+    SetVACoordinate(FVector2D::ZeroVector);
+    VAVelocity = FVector2f::ZeroVector;
+    DecayTimeBase = 0.0f;
+    DecayDitherIndex = 0;
+    bEmotionTagsDirty = false;
+    PendingCombinations.Init(false, EmotionLibrary ? EmotionLibrary->GetCombinationTable().Num() : 0);
+}
+
+void FEmotionStateData::Reset()
+{
+    EmotionLibrary = nullptr;
+    EmotionTagSet.Reset();
+    ActiveEmotions.Reset();
+    PendingCombinations.Reset();
+    SetVACoordinate(FVector2D::ZeroVector);
+    VAVelocity = FVector2f::ZeroVector;
+    InfluenceRadius = 0.3f;
+    SpringStiffness = 2.0f;
+    DampingFactor = 0.5f;
+    DecayTimeBase = 0.0f;
+    BatchTime = 0.0f;
+    BatchDepth = 0;
+    DecayDitherIndex = 0;
+    bEmotionTagsDirty = false;
+}
+
+void FEmotionStateData::Tick(float DeltaTime, float CurrentTime)
+{
+    // Apply decay to all active emotions
+    ApplyDecay(CurrentTime);
+    
+    // Update VA coordinate based on active emotions using the spring model
+    const FVector2D TargetVA = CalculateTargetVACoordinate();
+    if (!IsVACoordinateAtRest(TargetVA))
+    {
+        // The semi-implicit step stays stable for any DeltaTime
+        FVector2D VACoordinate = GetVACoordinate();
+        FVector2D Velocity = GetVAVelocity();
+        FEmotionSpring::Step(VACoordinate, Velocity, TargetVA, SpringStiffness, DampingFactor, DeltaTime);
+        ApplySpringStep(VACoordinate, Velocity, TargetVA, DeltaTime);
+    }
+    
+    // Process any potential emotion combinations
+    ProcessEmotionCombinations(CurrentTime);
+    
+    // Update emotion tags if an emotion entered, left or crossed into another intensity bracket
+    RequestEmotionTagsUpdate();
+}
+
+void FEmotionStateData::InitializeFromBaseline(const FEmotionStateData& Baseline, float CurrentTime)
+{
+    // Entries are inline and the tag set is shared, copying is a flat fill plus one reference count
+    *this = Baseline;
+    DecayTimeBase = CurrentTime;
+    BatchDepth = 0;
+    bEmotionTagsDirty = false;
+}
+
+bool FEmotionStateData::IsEquivalentTo(const FEmotionStateData& Baseline) const
+{
+    if (EmotionLibrary != Baseline.EmotionLibrary
+        || GetEmotionTagSetId() != Baseline.GetEmotionTagSetId()
+        || ActiveEmotions.Num() != Baseline.ActiveEmotions.Num()
+        || FMath::Abs(QuantizedVA[0] - Baseline.QuantizedVA[0]) > VARestToleranceSteps
+        || FMath::Abs(QuantizedVA[1] - Baseline.QuantizedVA[1]) > VARestToleranceSteps
+        || !VAVelocity.IsNearlyZero()
+        || InfluenceRadius != Baseline.InfluenceRadius
+        || SpringStiffness != Baseline.SpringStiffness
+        || DampingFactor != Baseline.DampingFactor
+        || BatchDepth > 0
+        || PendingCombinations.Find(true) != INDEX_NONE)
+    {
+        return false;
+    }
+    
+    // Same count and unique indices, so every entry having an equal counterpart means equal sets
+    for (const FEmotionCompactEntry& Entry : ActiveEmotions)
+    {
+        const FEmotionCompactEntry* BaselineEntry = Baseline.FindEntry(Entry.EmotionIndex);
+        if (!BaselineEntry || BaselineEntry->QuantizedIntensity != Entry.QuantizedIntensity)
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool FEmotionStateData::IsAtRest() const
+{
+    return ActiveEmotions.Num() == 0 && FMath::Abs(QuantizedVA[0]) <= VARestToleranceSteps && FMath::Abs(QuantizedVA[1]) <= VARestToleranceSteps
+        && VAVelocity.IsNearlyZero();
+}
+
+FVector2D FEmotionStateData::GetVACoordinate() const
+{
+    return FVector2D(QuantizedVA[0] / VACoordinateScale, QuantizedVA[1] / VACoordinateScale);
+}
+
+void FEmotionStateData::SetVACoordinate(const FVector2D& NewVACoordinate)
+{
+    QuantizedVA[0] = QuantizeVAAxis(NewVACoordinate.X);
+    QuantizedVA[1] = QuantizeVAAxis(NewVACoordinate.Y);
+}
+
+int16 FEmotionStateData::QuantizeVAAxis(double Value)
+{
+    // Clamp to valid VA space (-1,1), which is the full int16 range
+    return static_cast<int16>(FMath::RoundToInt32(FMath::Clamp(Value, -1.0, 1.0) * VACoordinateScale));
+}
+
+void FEmotionStateData::BeginBatch(float CurrentTime)
+{
+    if (BatchDepth++ == 0)
+    {
+        // Every change in the batch shares one timestamp
+        BatchTime = CurrentTime;
+    }
+}
+
+void FEmotionStateData::EndBatch()
+{
+    if (!ensureMsgf(BatchDepth > 0, TEXT("FEmotionStateData::EndBatch called without a matching BeginBatch")))
+    {
+        return;
+    }
+    
+    if (--BatchDepth == 0 && bEmotionTagsDirty)
+    {
+        UpdateEmotionTags();
+    }
+}
+
+void FEmotionStateData::RequestEmotionTagsUpdate()
+{
+    // Tags are still current, or rebuilt once when the outermost batch ends
+    if (!bEmotionTagsDirty || BatchDepth > 0)
+    {
+        return;
+    }
+    
+    UpdateEmotionTags();
+}
+
+void FEmotionStateData::SetEntryIntensity(FEmotionCompactEntry& Entry, float InIntensity)
+{
+    const int32 PreviousBracket = EmotionLibrary->FindIntensityBracket(Entry.EmotionIndex, Entry.GetIntensity());
+    Entry.SetIntensity(InIntensity);
+    bEmotionTagsDirty |= EmotionLibrary->FindIntensityBracket(Entry.EmotionIndex, Entry.GetIntensity()) != PreviousBracket;
+}
+
+FEmotionCompactEntry* FEmotionStateData::FindEntry(int32 EmotionIndex)
+{
+    return const_cast<FEmotionCompactEntry*>(static_cast<const FEmotionStateData*>(this)->FindEntry(EmotionIndex));
+}
+
+const FEmotionCompactEntry* FEmotionStateData::FindEntry(int32 EmotionIndex) const
+{
+    // A handful of 4 byte entries, a linear scan beats hashing
+    for (const FEmotionCompactEntry& Entry : ActiveEmotions)
+    {
+        if (Entry.EmotionIndex == EmotionIndex)
+        {
+            return &Entry;
+        }
+    }
+    
+    return nullptr;
+}
+
+FGameplayTag FEmotionStateData::GetEntryTag(const FEmotionCompactEntry& Entry) const
+{
+    const TConstArrayView<FGameplayTag> RuntimeTags = EmotionLibrary ? EmotionLibrary->GetRuntimeEmotionTags() : TConstArrayView<FGameplayTag>();
+    return RuntimeTags.IsValidIndex(Entry.EmotionIndex) ? RuntimeTags[Entry.EmotionIndex] : FGameplayTag::EmptyTag;
+}
+
+void FEmotionStateData::AddEntry(int32 EmotionIndex, float InIntensity, float ChangeTime)
+{
+    // Decay of a state without active emotions starts over from the first change
+    if (ActiveEmotions.Num() == 0)
+    {
+        DecayTimeBase = ChangeTime;
+    }
+    
+    ActiveEmotions.Emplace(EmotionIndex, InIntensity);
+    bEmotionTagsDirty = true;
+}
+
+float FEmotionStateData::GetIntensity(const FGameplayTag& InTag) const
+{
+    if (!EmotionLibrary)
+    {
+        return 0.0f;
+    }
+    
+    // Check if the tag is in active emotions
+    const FEmotionCompactEntry* Emotion = FindEntry(EmotionLibrary->FindEmotionIndex(InTag));
+    return Emotion ? Emotion->GetIntensity() : 0.0f;
+}
+
+void FEmotionStateData::AddEmotion(const FGameplayTag& InTag, float InIntensity, float CurrentTime)
+{
+    if (!EmotionLibrary)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("FEmotionStateData::AddEmotion - EmotionLibrary is not set!"));
+        return;
+    }
+
+    // Get the emotion data for this tag
+    const int32 EmotionIndex = EmotionLibrary->FindEmotionIndex(InTag);
+    if (EmotionIndex == INDEX_NONE)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("FEmotionStateData::AddEmotion - Could not find emotion data for tag %s"), *InTag.ToString());
+        return;
+    }
+
+    // Clamp intensity between 0 and 100
+    const float ClampedIntensity = FMath::Clamp(InIntensity, 0.0f, 100.0f);
+    
+    // Handle opposite emotions (adding to one reduces the other) : DISABLED
+    // HandleOppositeEmotions(InTag, ClampedIntensity, CurrentTime);
+    
+    // Check if emotion already exists
+    if (FEmotionCompactEntry* Emotion = FindEntry(EmotionIndex))
+    {
+        // Add to existing emotion intensity
+        SetEntryIntensity(*Emotion, FMath::Clamp(Emotion->GetIntensity() + ClampedIntensity, 0.0f, 100.0f));
+    }
+    else
+    {
+        // Create new active emotion
+        AddEntry(EmotionIndex, ClampedIntensity, GetChangeTime(CurrentTime));
+    }
+    MarkEmotionChanged(InTag);
+    
+    // Update emotion tags
+    RequestEmotionTagsUpdate();
+}
+
+void FEmotionStateData::RemoveEmotion(const FGameplayTag& InTag)
+{
+    if (!EmotionLibrary)
+    {
+        return;
+    }
+    
+    const int32 EmotionIndex = EmotionLibrary->FindEmotionIndex(InTag);
+    const int32 EntryIndex = ActiveEmotions.IndexOfByPredicate([EmotionIndex](const FEmotionCompactEntry& Entry)
+    {
+        return Entry.EmotionIndex == EmotionIndex;
+    });
+    
+    if (EntryIndex != INDEX_NONE)
+    {
+        ActiveEmotions.RemoveAtSwap(EntryIndex);
+        bEmotionTagsDirty = true;
+        MarkEmotionChanged(InTag);
+        
+        // Update emotion tags
+        RequestEmotionTagsUpdate();
+    }
+}
+
+void FEmotionStateData::SetIntensity(const FGameplayTag& InTag, float InIntensity, float CurrentTime)
+{
+    if (!EmotionLibrary)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("FEmotionStateData::SetIntensity - EmotionLibrary is not set!"));
+        return;
+    }
+
+    // Get the emotion data for this tag
+    const int32 EmotionIndex = EmotionLibrary->FindEmotionIndex(InTag);
+    if (EmotionIndex == INDEX_NONE)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("FEmotionStateData::SetIntensity - Could not find emotion data for tag %s"), *InTag.ToString());
+        return;
+    }
+
+    // Clamp intensity between 0 and 100
+    const float ClampedIntensity = FMath::Clamp(InIntensity, 0.0f, 100.0f);
+    
+    // Handle opposite emotions (setting one affects the other) : DISABLED 
+    // HandleOppositeEmotions(InTag, ClampedIntensity, CurrentTime);
+    
+    // Check if emotion already exists
+    if (FEmotionCompactEntry* Emotion = FindEntry(EmotionIndex))
+    {
+        // Update existing emotion intensity
+        SetEntryIntensity(*Emotion, ClampedIntensity);
+        MarkEmotionChanged(InTag);
+    }
+    else if (ClampedIntensity > 0.0f)
+    {
+        // Create new active emotion if intensity > 0
+        AddEntry(EmotionIndex, ClampedIntensity, GetChangeTime(CurrentTime));
+        MarkEmotionChanged(InTag);
+    }
+    
+    // Update emotion tags
+    RequestEmotionTagsUpdate();
+}
+
+TArray<FActiveEmotion> FEmotionStateData::GetActiveEmotions() const
+{
+    TArray<FActiveEmotion> Result;
+    if (!EmotionLibrary)
+    {
+        return Result;
+    }
+    
+    // Resolve the definitions only for the Blueprint view
+    const TConstArrayView<UEmotionDefinition*> Definitions = EmotionLibrary->GetRuntimeEmotions();
+    Result.Reserve(ActiveEmotions.Num());
+    for (const FEmotionCompactEntry& Entry : ActiveEmotions)
+    {
+        UEmotionDefinition* EmotionData = Definitions.IsValidIndex(Entry.EmotionIndex) ? Definitions[Entry.EmotionIndex] : nullptr;
+        Result.Emplace(EmotionData, Entry.GetIntensity(), DecayTimeBase);
+    }
+    return Result;
+}
+
+void FEmotionStateData::ForEachActiveEmotion(TFunctionRef<void(const FGameplayTag&, float)> Visitor) const
+{
+    for (const FEmotionCompactEntry& Entry : ActiveEmotions)
+    {
+        Visitor(GetEntryTag(Entry), Entry.GetIntensity());
+    }
+}
+
+void FEmotionStateData::GetDominantEmotion(FGameplayTag& OutEmotionTag, float& OutIntensity) const
+{
+    OutEmotionTag = FGameplayTag::EmptyTag;
+    OutIntensity = 0.0f;
+    
+    // Find the emotion with the highest intensity
+    const FEmotionCompactEntry* DominantEntry = nullptr;
+    for (const FEmotionCompactEntry& Entry : ActiveEmotions)
+    {
+        if (!DominantEntry || Entry.QuantizedIntensity > DominantEntry->QuantizedIntensity)
+        {
+            DominantEntry = &Entry;
+        }
+    }
+    
+    if (DominantEntry && DominantEntry->QuantizedIntensity > 0)
+    {
+        OutEmotionTag = GetEntryTag(*DominantEntry);
+        OutIntensity = DominantEntry->GetIntensity();
+    }
+}
+
+TArray<UEmotionDefinition*> FEmotionStateData::FindEmotionsInRadius(float Radius) const
+{
+    if (!EmotionLibrary)
+    {
+        return TArray<UEmotionDefinition*>();
+    }
+    
+    return EmotionLibrary->FindEmotionsInRadius(GetVACoordinate(), Radius);
+}
+
+FVector2D FEmotionStateData::CalculateTargetVACoordinate() const
+{
+    // Calculate the target VA coordinate based on active emotions
+    FVector2D TargetVA = FVector2D::ZeroVector;
+    float TotalIntensity = 0.0f;
+    
+    if (!EmotionLibrary)
+    {
+        return TargetVA;
+    }
+    
+    // Each emotion pulls the VA coordinate toward its own VA coordinate
+    // with force proportional to its intensity
+    const TConstArrayView<FEmotionCompiledEmotion> CompiledEmotions = EmotionLibrary->GetCompiledEmotions();
+    for (const FEmotionCompactEntry& Entry : ActiveEmotions)
+    {
+        if (CompiledEmotions.IsValidIndex(Entry.EmotionIndex))
+        {
+            const FVector2D EmotionVA = CompiledEmotions[Entry.EmotionIndex].Coordinate;
+            const float Intensity = Entry.GetIntensity();
+            
+            // Add weighted contribution
+            TargetVA += EmotionVA * Intensity;
+            TotalIntensity += Intensity;
+        }
+    }
+    
+    // Without active emotions the state returns to neutral (0,0)
+    if (TotalIntensity <= 0.0f)
+    {
+        return FVector2D::ZeroVector;
+    }
+    
+    // Normalize the target VA coordinate and clamp to valid VA space (-1,1) for both axes
+    TargetVA /= TotalIntensity;
+    TargetVA.X = FMath::Clamp(TargetVA.X, -1.0f, 1.0f);
+    TargetVA.Y = FMath::Clamp(TargetVA.Y, -1.0f, 1.0f);
+    return TargetVA;
+}
+
+bool FEmotionStateData::IsVACoordinateAtRest(const FVector2D& TargetVA) const
+{
+    // One quantization step is well inside the comparison tolerance
+    return VAVelocity.IsNearlyZero() && GetVACoordinate().Equals(TargetVA);
+}
+
+void FEmotionStateData::ApplySpringStep(const FVector2D& NewVACoordinate, const FVector2D& NewVelocity, const FVector2D& TargetVA, float DeltaTime)
+{
+    const int16 PreviousVA[2] = { QuantizedVA[0], QuantizedVA[1] };
+    SetVACoordinate(NewVACoordinate);
+    SetVAVelocity(NewVelocity);
+
+    const int16 TargetSteps[2] = { QuantizeVAAxis(TargetVA.X), QuantizeVAAxis(TargetVA.Y) };
+    const float Velocity[2] = { VAVelocity.X, VAVelocity.Y };
+    bool bSettled = true;
+    for (int32 Axis = 0; Axis < 2; ++Axis)
+    {
+        // Without the nudge the float velocity keeps integrating against the rounding and the state never rests
+        const int32 TargetDirection = (TargetSteps[Axis] > QuantizedVA[Axis]) - (TargetSteps[Axis] < QuantizedVA[Axis]);
+        const int32 VelocityDirection = (Velocity[Axis] > 0.0f) - (Velocity[Axis] < 0.0f);
+        if (QuantizedVA[Axis] == PreviousVA[Axis] && TargetDirection != 0 && VelocityDirection == TargetDirection)
+        {
+            QuantizedVA[Axis] = static_cast<int16>(QuantizedVA[Axis] + TargetDirection);
+        }
+
+        bSettled &= QuantizedVA[Axis] == TargetSteps[Axis] && FMath::Abs(Velocity[Axis]) * DeltaTime * VACoordinateScale < 0.5f;
+    }
+
+    if (bSettled)
+    {
+        VAVelocity = FVector2f::ZeroVector;
+    }
+}
+
+void FEmotionStateData::ApplyDecay(float CurrentTime)
+{
+    if (!EmotionLibrary)
+    {
+        return;
+    }
+    
+    // Every active emotion decays from the shared time base, emotions changed since the last tick included
+    const float TimeSinceUpdate = CurrentTime - DecayTimeBase;
+    DecayTimeBase = CurrentTime;
+    
+    // Golden ratio sequence in [0,1), spreads the rounding error of small decay steps evenly over ticks
+    const float Dither = FMath::Frac(++DecayDitherIndex * 0.618034f);
+    
+    // Apply decay to all active emotions, backwards so decayed entries can be swapped out
+    const TConstArrayView<FEmotionCompiledEmotion> CompiledEmotions = EmotionLibrary->GetCompiledEmotions();
+    for (int32 EntryIndex = ActiveEmotions.Num() - 1; EntryIndex >= 0; --EntryIndex)
+    {
+        FEmotionCompactEntry& Emotion = ActiveEmotions[EntryIndex];
+        if (!CompiledEmotions.IsValidIndex(Emotion.EmotionIndex))
+        {
+            continue;
+        }
+        
+        // Apply decay based on the emotion's decay rate, the tags only need a rebuild if it crossed into another bracket
+        const float DecayAmount = CompiledEmotions[Emotion.EmotionIndex].DecayRate * TimeSinceUpdate;
+        if (DecayAmount > 0.0f && Emotion.QuantizedIntensity > 0)
+        {
+            const int32 PreviousBracket = EmotionLibrary->FindIntensityBracket(Emotion.EmotionIndex, Emotion.GetIntensity());
+            Emotion.Decay(DecayAmount, Dither);
+            bEmotionTagsDirty |= EmotionLibrary->FindIntensityBracket(Emotion.EmotionIndex, Emotion.GetIntensity()) != PreviousBracket;
+            MarkEmotionChanged(GetEntryTag(Emotion));
+        }
+        
+        // Remove emotions that have decayed to zero
+        if (Emotion.QuantizedIntensity == 0)
+        {
+            const FGameplayTag RemovedTag = GetEntryTag(Emotion);
+            ActiveEmotions.RemoveAtSwap(EntryIndex);
+            bEmotionTagsDirty = true;
+            MarkEmotionChanged(RemovedTag);
+        }
+    }
+}
+
+bool FEmotionStateData::HasEmotionTag(const FGameplayTag& InTag) const
+{
+    const FEmotionTagSet& TagSet = EmotionTagSet.Get();
+    if (TagSet.HasCurrentMask(EmotionLibrary))
+    {
+        // Tags outside the library's space can never be carried by this state
+        const int32 TagIndex = EmotionLibrary->GetTagSpace().GetTagIndex(InTag);
+        return TagIndex != INDEX_NONE && TagSet.Mask.TestBit(TagIndex);
+    }
+    
+    return TagSet.Tags.HasTag(InTag);
+}
+
+bool FEmotionStateData::MatchesAnyEmotionTags(const FEmotionTagQueryMask& Query) const
+{
+    const FEmotionTagSet& TagSet = EmotionTagSet.Get();
+    if (TagSet.HasCurrentMask(EmotionLibrary))
+    {
+        return Query.MatchesAny(EmotionLibrary->GetTagSpace(), TagSet.Mask);
+    }
+    
+    return TagSet.Tags.HasAny(Query.GetTags());
+}
+
+bool FEmotionStateData::MatchesAllEmotionTags(const FEmotionTagQueryMask& Query) const
+{
+    const FEmotionTagSet& TagSet = EmotionTagSet.Get();
+    if (TagSet.HasCurrentMask(EmotionLibrary))
+    {
+        return Query.MatchesAll(EmotionLibrary->GetTagSpace(), TagSet.Mask);
+    }
+    
+    return TagSet.Tags.HasAll(Query.GetTags());
+}
+
+void FEmotionStateData::UpdateEmotionTags()
+{
+    bEmotionTagsDirty = false;
+    
+    FGameplayTagContainer EmotionTags;
+    
+    // Add the main tag of every active emotion, the range tags its intensity triggers and the variations of its links,
+    // which also depend on the intensity of the linked emotion
+    if (EmotionLibrary)
+    {
+        TArray<int32, TInlineAllocator<NumInlineEmotions>> EmotionIndices;
+        TArray<float, TInlineAllocator<NumInlineEmotions>> Intensities;
+        for (const FEmotionCompactEntry& Entry : ActiveEmotions)
+        {
+            EmotionIndices.Add(Entry.EmotionIndex);
+            Intensities.Add(Entry.GetIntensity());
+        }
+        EmotionLibrary->AppendTriggeredTags(EmotionIndices, Intensities, EmotionTags);
+    }
+    
+    // Share the set with every agent carrying the same tags, the table also builds its bit mask once per set.
+    // A set interned before the library recompiled is replaced even if the tags did not change.
+    const FEmotionTagSet& CurrentSet = EmotionTagSet.Get();
+    if (!(CurrentSet.Tags == EmotionTags) || (CurrentSet.bHasMask && !CurrentSet.HasCurrentMask(EmotionLibrary)))
+    {
+        EmotionTagSet = FEmotionTagSetTable::Get().Intern(EmotionLibrary, EmotionTags);
+    }
+}
+
+void FEmotionStateData::HandleOppositeEmotions(const FGameplayTag& InTag, float InIntensity, float CurrentTime)
+{
+    if (!EmotionLibrary)
+    {
+        return;
+    }
+    
+    // Opposites are resolved to runtime emotion indices when the library is compiled
+    const int32 EmotionIndex = EmotionLibrary->FindEmotionIndex(InTag);
+    if (EmotionIndex == INDEX_NONE)
+    {
+        return;
+    }
+    
+    const int32 OppositeIndex = EmotionLibrary->GetCompiledEmotions()[EmotionIndex].OppositeIndex;
+    
+    // Check if the opposite emotion is active
+    if (FEmotionCompactEntry* OppositeEmotion = FindEntry(OppositeIndex))
+    {
+        const FGameplayTag OppositeTag = GetEntryTag(*OppositeEmotion);
+        
+        // Reduce the opposite emotion's intensity
+        // The reduction is proportional to the intensity being added
+        float ReductionAmount = InIntensity * 0.5f; // Adjust this factor as needed
+        SetEntryIntensity(*OppositeEmotion, FMath::Max(0.0f, OppositeEmotion->GetIntensity() - ReductionAmount));
+        
+        // If the opposite emotion's intensity is reduced to zero, remove it
+        if (OppositeEmotion->QuantizedIntensity == 0)
+        {
+            ActiveEmotions.RemoveAtSwap(UE_PTRDIFF_TO_INT32(OppositeEmotion - ActiveEmotions.GetData()));
+            bEmotionTagsDirty = true;
+        }
+        MarkEmotionChanged(OppositeTag);
+    }
+}
+
+void FEmotionStateData::MarkEmotionChanged(const FGameplayTag& InTag)
+{
+    if (!EmotionLibrary)
+    {
+        return;
+    }
+    
+    // Size mismatch means the library was recompiled, ProcessEmotionCombinations will re-evaluate everything
+    const FEmotionCombinationTable& CombinationTable = EmotionLibrary->GetCombinationTable();
+    if (PendingCombinations.Num() != CombinationTable.Num())
+    {
+        return;
+    }
+    
+    if (const TArray<int32>* AffectedCombinations = CombinationTable.FindAffectedCombinations(InTag))
+    {
+        for (const int32 CombinationIndex : *AffectedCombinations)
+        {
+            PendingCombinations[CombinationIndex] = true;
+        }
+    }
+}
+
+bool FEmotionStateData::AreCombinationTriggersActive(const FEmotionCompiledCombination& Combination, const FEmotionTagMask& ActiveEmotionMask) const
+{
+    if (EmotionLibrary->GetTagSpace().IsValid())
+    {
+        return ActiveEmotionMask.HasAll(Combination.TriggerMask);
+    }
+    
+    // Tag space overflowed, match the triggers against the active tags directly
+    for (const FGameplayTag& TriggerTag : Combination.TriggerTags)
+    {
+        const bool bTriggerPresent = ActiveEmotions.ContainsByPredicate([this, &TriggerTag](const FEmotionCompactEntry& Entry)
+        {
+            return GetEntryTag(Entry).MatchesTag(TriggerTag);
+        });
+        
+        if (!bTriggerPresent)
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+void FEmotionStateData::ProcessEmotionCombinations(float CurrentTime)
+{
+    if (!EmotionLibrary)
+    {
+        return;
+    }
+    
+    const FEmotionCombinationTable& CombinationTable = EmotionLibrary->GetCombinationTable();
+    if (CombinationTable.Num() == 0)
+    {
+        return;
+    }
+    
+    // The library was recompiled since this state was initialized, evaluate everything once
+    if (PendingCombinations.Num() != CombinationTable.Num())
+    {
+        PendingCombinations.Init(true, CombinationTable.Num());
+    }
+    
+    // Nothing entered, left or changed intensity since the last tick
+    if (PendingCombinations.Find(true) == INDEX_NONE)
+    {
+        return;
+    }
+    
+    // Evaluate a snapshot, changes made by combination results are picked up on the next tick
+    TBitArray<> CombinationsToEvaluate = MoveTemp(PendingCombinations);
+    PendingCombinations.Init(false, CombinationTable.Num());
+    
+    // Hierarchical mask of the active emotion tags, built once per evaluation instead of stored per state
+    const FEmotionTagSpace& TagSpace = EmotionLibrary->GetTagSpace();
+    FEmotionTagMask ActiveEmotionMask;
+    if (TagSpace.IsValid())
+    {
+        for (const FEmotionCompactEntry& Entry : ActiveEmotions)
+        {
+            TagSpace.AppendTag(ActiveEmotionMask, GetEntryTag(Entry));
+        }
+    }
+    
+    for (TConstSetBitIterator<> It(CombinationsToEvaluate); It; ++It)
+    {
+        const FEmotionCompiledCombination& Combination = CombinationTable.Combinations[It.GetIndex()];
+        if (!AreCombinationTriggersActive(Combination, ActiveEmotionMask))
+        {
+            continue;
+        }
+        
+        // Track the minimum intensity among trigger emotions
+        float MinIntensity = FLT_MAX;
+        for (const FGameplayTag& TriggerTag : Combination.TriggerTags)
+        {
+            MinIntensity = FMath::Min(MinIntensity, GetIntensity(TriggerTag));
+        }
+        
+        // Only add if not already present with higher intensity
+        FEmotionCompactEntry* ResultEmotion = FindEntry(Combination.ResultEmotionIndex);
+        const float CurrentIntensity = ResultEmotion ? ResultEmotion->GetIntensity() : 0.0f;
+        if (MinIntensity > CurrentIntensity)
+        {
+            // Create or update the combined emotion
+            if (ResultEmotion)
+            {
+                SetEntryIntensity(*ResultEmotion, MinIntensity);
+            }
+            else
+            {
+                AddEntry(Combination.ResultEmotionIndex, MinIntensity, CurrentTime);
+                if (TagSpace.IsValid())
+                {
+                    TagSpace.AppendTag(ActiveEmotionMask, Combination.ResultTag);
+                }
+            }
+            MarkEmotionChanged(Combination.ResultTag);
+        }
+    }
+}
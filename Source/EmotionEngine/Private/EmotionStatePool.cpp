@@ -0,0 +1,172 @@
+#include "EmotionStatePool.h"
+#include "EmotionEngine.h"
+#include "EmotionSpring.h"
+
+FEmotionStateHandle FEmotionStatePool::Allocate(UEmotionLibrary* Library)
+{
+    const FEmotionStateHandle Handle = AllocateSlot();
+    States[Handle.Index].Initialize(Library);
+    return Handle;
+}
+
+void FEmotionStatePool::AllocateCopies(const FEmotionStateData& Source, float CurrentTime, int32 Count, TArray<FEmotionStateHandle>& OutHandles)
+{
+    Reserve(Num() + Count);
+    OutHandles.Reserve(OutHandles.Num() + Count);
+
+    for (int32 Copy = 0; Copy < Count; ++Copy)
+    {
+        const FEmotionStateHandle Handle = AllocateSlot();
+        States[Handle.Index].InitializeFromBaseline(Source, CurrentTime);
+        OutHandles.Add(Handle);
+    }
+}
+
+void FEmotionStatePool::Reserve(int32 NumStates)
+{
+    LLM_SCOPE_BYTAG(EmotionEngine);
+
+    // Free slots are reused before the arrays grow
+    const int32 NumNewSlots = NumStates - Num() - FreeIndices.Num();
+    if (NumNewSlots <= 0)
+    {
+        return;
+    }
+
+    States.Reserve(States.Num() + NumNewSlots);
+    Generations.Reserve(States.Num() + NumNewSlots);
+    LiveStates.Reserve(States.Num() + NumNewSlots);
+}
+
+FEmotionStateHandle FEmotionStatePool::AllocateSlot()
+{
+    LLM_SCOPE_BYTAG(EmotionEngine);
+
+    FEmotionStateHandle Handle;
+    if (FreeIndices.Num() > 0)
+    {
+        Handle.Index = FreeIndices.Pop(EAllowShrinking::No);
+        LiveStates[Handle.Index] = true;
+    }
+    else
+    {
+        Handle.Index = States.AddDefaulted();
+        Generations.Add(0);
+        LiveStates.Add(true);
+    }
+
+    Handle.Generation = Generations[Handle.Index];
+    return Handle;
+}
+
+void FEmotionStatePool::Release(const FEmotionStateHandle& Handle)
+{
+    if (!Get(Handle))
+    {
+        return;
+    }
+
+    // Drop the slot's emotions now rather than when it is reused, the slot keeps its storage for the next owner
+    States[Handle.Index].Reset();
+    ++Generations[Handle.Index];
+    LiveStates[Handle.Index] = false;
+    FreeIndices.Push(Handle.Index);
+}
+
+FEmotionStateData* FEmotionStatePool::Get(const FEmotionStateHandle& Handle)
+{
+    return const_cast<FEmotionStateData*>(static_cast<const FEmotionStatePool*>(this)->Get(Handle));
+}
+
+const FEmotionStateData* FEmotionStatePool::Get(const FEmotionStateHandle& Handle) const
+{
+    if (States.IsValidIndex(Handle.Index) && LiveStates[Handle.Index] && Generations[Handle.Index] == Handle.Generation)
+    {
+        return &States[Handle.Index];
+    }
+    return nullptr;
+}
+
+void FEmotionStatePool::Tick(float DeltaTime, float CurrentTime)
+{
+    SpringStates.Reset();
+    PositionX.Reset();
+    PositionY.Reset();
+    VelocityX.Reset();
+    VelocityY.Reset();
+    TargetX.Reset();
+    TargetY.Reset();
+    Stiffness.Reset();
+    Damping.Reset();
+
+    // Decay every state and gather the springs that are still moving
+    for (TConstSetBitIterator<> It(LiveStates); It; ++It)
+    {
+        FEmotionStateData& State = States[It.GetIndex()];
+        State.ApplyDecay(CurrentTime);
+
+        const FVector2D TargetVA = State.CalculateTargetVACoordinate();
+        if (State.IsVACoordinateAtRest(TargetVA))
+        {
+            continue;
+        }
+
+        const FVector2D VACoordinate = State.GetVACoordinate();
+        SpringStates.Add(It.GetIndex());
+        PositionX.Add(VACoordinate.X);
+        PositionY.Add(VACoordinate.Y);
+        VelocityX.Add(State.VAVelocity.X);
+        VelocityY.Add(State.VAVelocity.Y);
+        TargetX.Add(TargetVA.X);
+        TargetY.Add(TargetVA.Y);
+        Stiffness.Add(State.SpringStiffness);
+        Damping.Add(State.DampingFactor);
+    }
+
+    if (SpringStates.Num() > 0)
+    {
+        FEmotionSpring::StepBatch(PositionX, PositionY, VelocityX, VelocityY, TargetX, TargetY, Stiffness, Damping, DeltaTime);
+
+        for (int32 SpringIndex = 0; SpringIndex < SpringStates.Num(); ++SpringIndex)
+        {
+            FEmotionStateData& State = States[SpringStates[SpringIndex]];
+            State.ApplySpringStep(FVector2D(PositionX[SpringIndex], PositionY[SpringIndex]), FVector2D(VelocityX[SpringIndex], VelocityY[SpringIndex]),
+                FVector2D(TargetX[SpringIndex], TargetY[SpringIndex]), DeltaTime);
+        }
+    }
+
+    // Combinations and tags see the decayed intensities, same order as FEmotionStateData::Tick
+    for (TConstSetBitIterator<> It(LiveStates); It; ++It)
+    {
+        FEmotionStateData& State = States[It.GetIndex()];
+        State.ProcessEmotionCombinations(CurrentTime);
+        State.RequestEmotionTagsUpdate();
+    }
+}
+
+SIZE_T FEmotionStatePool::GetAllocatedSize() const
+{
+    SIZE_T Size = States.GetAllocatedSize() + Generations.GetAllocatedSize() + LiveStates.GetAllocatedSize() + FreeIndices.GetAllocatedSize();
+    for (const FEmotionStateData& State : States)
+    {
+        Size += State.GetAllocatedSize();
+    }
+    return Size;
+}
+
+SIZE_T FEmotionStatePool::GetScratchAllocatedSize() const
+{
+    return SpringStates.GetAllocatedSize()
+        + PositionX.GetAllocatedSize() + PositionY.GetAllocatedSize()
+        + VelocityX.GetAllocatedSize() + VelocityY.GetAllocatedSize()
+        + TargetX.GetAllocatedSize() + TargetY.GetAllocatedSize()
+        + Stiffness.GetAllocatedSize() + Damping.GetAllocatedSize();
+}
+
+void FEmotionStatePool::Reset()
+{
+    States.Empty();
+    Generations.Empty();
+    LiveStates.Empty();
+    FreeIndices.Empty();
+}
@@ -1,13 +1,63 @@
 #include "EmotionSubsystem.h"
+#include "EmotionEngine.h"
 #include "EmotionComponent.h"
 #include "EmotionSystemLibrary.h"
 #include "EmotionData.h"
+#include "EmotionArchetype.h"
+#include "PolarCoordinate.h"
 #include "GameFramework/Actor.h"
 #include "Kismet/GameplayStatics.h"
+#include "Engine/AssetManager.h"
 #include "DrawDebugHelpers.h"
+#include "HAL/IConsoleManager.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(EmotionSubsystem)
 
+static FAutoConsoleCommandWithWorldAndArgs EmotionMemReportCommand(
+	TEXT("emotion.MemReport"),
+	TEXT("Log emotion system memory by category, by archetype and for the agents using the most. Usage: emotion.MemReport [NumTopAgents]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const UEmotionSubsystem* EmotionSubsystem = World ? World->GetSubsystem<UEmotionSubsystem>() : nullptr;
+		if (!EmotionSubsystem)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("emotion.MemReport - No EmotionSubsystem in this world"));
+			return;
+		}
+		
+		EmotionSubsystem->DebugLogMemoryReport(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10);
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs EmotionBenchmarkClosestCommand(
+	TEXT("emotion.BenchmarkClosestEmotion"),
+	TEXT("Time the exact and approximate closest emotion lookups of the default library against a full scan. Usage: emotion.BenchmarkClosestEmotion [NumQueries]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const UEmotionSubsystem* EmotionSubsystem = World ? World->GetSubsystem<UEmotionSubsystem>() : nullptr;
+		if (!EmotionSubsystem)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("emotion.BenchmarkClosestEmotion - No EmotionSubsystem in this world"));
+			return;
+		}
+		
+		EmotionSubsystem->DebugBenchmarkClosestEmotion(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100000);
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs EmotionBenchmarkPolarCommand(
+	TEXT("emotion.BenchmarkPolarConversions"),
+	TEXT("Time the batch polar conversions against the scalar UPolarCoordinateLibrary functions. Usage: emotion.BenchmarkPolarConversions [NumCoordinates]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const UEmotionSubsystem* EmotionSubsystem = World ? World->GetSubsystem<UEmotionSubsystem>() : nullptr;
+		if (!EmotionSubsystem)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("emotion.BenchmarkPolarConversions - No EmotionSubsystem in this world"));
+			return;
+		}
+		
+		EmotionSubsystem->DebugBenchmarkPolarConversions(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100000);
+	}));
+
 void UEmotionSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
@@ -15,30 +65,211 @@ void UEmotionSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	// Initialize the subsystem
 	UE_LOG(LogTemp, Log, TEXT("EmotionSubsystem initialized"));
 	
-	// Initialize the default emotion library
-	DefaultEmotionLibrary = UEmotionSystemLibrary::GetDefaultEmotionLibrary();
+	// Resolve the default emotion library once for this world, without blocking on a load
+	RequestDefaultEmotionLibrary();
+	ReloadCompleteHandle = FCoreUObjectDelegates::ReloadCompleteDelegate.AddUObject(this, &UEmotionSubsystem::HandleReloadComplete);
+}
+
+void UEmotionSubsystem::RequestDefaultEmotionLibrary()
+{
+	const FSoftObjectPath LibraryPath = UEmotionSystemLibrary::GetDefaultEmotionLibraryPath();
+	if (LibraryPath.IsNull())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("EmotionSubsystem - No emotion library found to use as default"));
+		return;
+	}
+	
+	// Usable right away if already in memory, the request below still brings in its bundles
+	DefaultEmotionLibrary = Cast<UEmotionLibrary>(LibraryPath.ResolveObject());
+	
+	DefaultLibraryLoadHandle = UEmotionSystemLibrary::LoadEmotionLibraryAsync(LibraryPath,
+		FStreamableDelegate::CreateUObject(this, &UEmotionSubsystem::OnDefaultEmotionLibraryLoaded));
+	
+	// A load that finished inside the request ran the callback before the handle was set
+	if (DefaultLibraryLoadHandle.IsValid() && DefaultLibraryLoadHandle->HasLoadCompleted())
+	{
+		OnDefaultEmotionLibraryLoaded();
+	}
+	else if (!DefaultLibraryLoadHandle.IsValid())
+	{
+		DefaultEmotionLibrary = Cast<UEmotionLibrary>(LibraryPath.ResolveObject());
+	}
+}
+
+void UEmotionSubsystem::OnDefaultEmotionLibraryLoaded()
+{
+	// Completed inside the request or already handled, see RequestDefaultEmotionLibrary
+	if (!DefaultLibraryLoadHandle.IsValid())
+	{
+		return;
+	}
+	
+	// Resolved by path, the handle also holds the assets of the loaded bundles
+	const FSoftObjectPath LibraryPath = UEmotionSystemLibrary::GetDefaultEmotionLibraryPath();
+	UEmotionLibrary* LoadedLibrary = Cast<UEmotionLibrary>(LibraryPath.ResolveObject());
+	if (!bDefaultEmotionLibraryOverridden)
+	{
+		DefaultEmotionLibrary = LoadedLibrary;
+	}
+	
+	UE_CLOG(!LoadedLibrary, LogTemp, Warning, TEXT("EmotionSubsystem - Failed to load the default emotion library %s"), *LibraryPath.ToString());
+	
+	// The library is referenced by DefaultEmotionLibrary from here on
+	DefaultLibraryLoadHandle.Reset();
+}
+
+void UEmotionSubsystem::HandleReloadComplete(EReloadCompleteReason Reason)
+{
+	UEmotionSystemLibrary::InvalidateDefaultEmotionLibrary();
+	
+	bDefaultEmotionLibraryOverridden = false;
+	DefaultEmotionLibrary = nullptr;
+	if (DefaultLibraryLoadHandle.IsValid())
+	{
+		DefaultLibraryLoadHandle->CancelHandle();
+		DefaultLibraryLoadHandle.Reset();
+	}
+	RequestDefaultEmotionLibrary();
 }
 
 void UEmotionSubsystem::Deinitialize()
 {
 	// Clear all registered components
 	RegisteredComponents.Empty();
+	RegisteredComponentIndices.Empty();
 	DefaultEmotionLibrary = nullptr;
 	
+	FCoreUObjectDelegates::ReloadCompleteDelegate.Remove(ReloadCompleteHandle);
+	if (DefaultLibraryLoadHandle.IsValid())
+	{
+		DefaultLibraryLoadHandle->CancelHandle();
+		DefaultLibraryLoadHandle.Reset();
+	}
+	
+	// Outstanding handles stop resolving
+	StatePool.Reset();
+	PooledStateLibraries.Empty();
+	PooledStateComponents.Empty();
+	PooledStateComponentIndices.Empty();
+	PooledComponentsToUpdate.Empty();
+	
 	UE_LOG(LogTemp, Log, TEXT("EmotionSubsystem deinitialized"));
 	
 	Super::Deinitialize();
 }
 
+void UEmotionSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	
+#if STATS
+	// Walks every component, only worth it while someone is looking at the stats
+	if (FThreadStats::IsCollectingData())
+	{
+		UpdateMemoryStats();
+	}
+#endif
+	
+	if (StatePool.Num() == 0)
+	{
+		return;
+	}
+	
+	// Listeners may add or remove pooled components while being notified
+	PooledComponentsToUpdate = PooledStateComponents;
+	
+	for (const TWeakObjectPtr<UEmotionComponent>& WeakComponent : PooledComponentsToUpdate)
+	{
+		if (UEmotionComponent* Component = WeakComponent.Get())
+		{
+			Component->SyncStateSettings();
+		}
+	}
+	
+	// Advance every pooled state in one pass
+	StatePool.Tick(DeltaTime, GetWorld()->GetTimeSeconds());
+	
+	for (const TWeakObjectPtr<UEmotionComponent>& WeakComponent : PooledComponentsToUpdate)
+	{
+		if (UEmotionComponent* Component = WeakComponent.Get())
+		{
+			Component->DispatchChangeNotifications();
+			
+			// Agents back at their archetype's resting baseline give their state back to the pool
+			Component->TryCollapseToArchetypeBaseline();
+		}
+	}
+	
+	PooledComponentsToUpdate.Reset();
+}
+
+TStatId UEmotionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEmotionSubsystem, STATGROUP_Tickables);
+}
+
+FEmotionStateHandle UEmotionSubsystem::AcquirePooledState(UEmotionComponent* Component, UEmotionLibrary* Library)
+{
+	if (!Component)
+	{
+		return FEmotionStateHandle();
+	}
+	
+	if (Library)
+	{
+		PooledStateLibraries.Add(Library);
+	}
+	
+	AddIndexedComponent(PooledStateComponents, PooledStateComponentIndices, Component);
+	return StatePool.Allocate(Library);
+}
+
+void UEmotionSubsystem::ReleasePooledState(UEmotionComponent* Component, const FEmotionStateHandle& Handle)
+{
+	StatePool.Release(Handle);
+	RemoveIndexedComponent(PooledStateComponents, PooledStateComponentIndices, Component);
+}
+
+bool UEmotionSubsystem::AddIndexedComponent(TArray<TWeakObjectPtr<UEmotionComponent>>& Components,
+	TMap<TWeakObjectPtr<UEmotionComponent>, int32>& Indices, UEmotionComponent* Component)
+{
+	TWeakObjectPtr<UEmotionComponent> WeakComponent(Component);
+	if (Indices.Contains(WeakComponent))
+	{
+		return false;
+	}
+	
+	Indices.Add(WeakComponent, Components.Add(WeakComponent));
+	return true;
+}
+
+bool UEmotionSubsystem::RemoveIndexedComponent(TArray<TWeakObjectPtr<UEmotionComponent>>& Components,
+	TMap<TWeakObjectPtr<UEmotionComponent>, int32>& Indices, UEmotionComponent* Component)
+{
+	// The last entry moves into the gap
+	int32 Index;
+	if (!Indices.RemoveAndCopyValue(TWeakObjectPtr<UEmotionComponent>(Component), Index))
+	{
+		return false;
+	}
+	
+	Components.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	if (Components.IsValidIndex(Index))
+	{
+		Indices[Components[Index]] = Index;
+	}
+	return true;
+}
+
 void UEmotionSubsystem::RegisterEmotionComponent(UEmotionComponent* Component)
 {
+	LLM_SCOPE_BYTAG(EmotionEngine);
+	
 	if (Component)
 	{
 		// Add to the registered components array if not already present
-		TWeakObjectPtr<UEmotionComponent> WeakComponent(Component);
-		if (!RegisteredComponents.Contains(WeakComponent))
+		if (AddIndexedComponent(RegisteredComponents, RegisteredComponentIndices, Component))
 		{
-			RegisteredComponents.Add(WeakComponent);
 			UE_LOG(LogTemp, Verbose, TEXT("Registered EmotionComponent for %s"), *Component->GetOwnerName());
 		}
 	}
@@ -49,14 +280,83 @@ void UEmotionSubsystem::UnregisterEmotionComponent(UEmotionComponent* Component)
 	if (Component)
 	{
 		// Remove from the registered components array
-		TWeakObjectPtr<UEmotionComponent> WeakComponent(Component);
-		if (RegisteredComponents.Remove(WeakComponent) > 0)
+		if (RemoveIndexedComponent(RegisteredComponents, RegisteredComponentIndices, Component))
 		{
 			UE_LOG(LogTemp, Verbose, TEXT("Unregistered EmotionComponent for %s"), *Component->GetOwnerName());
 		}
 	}
 }
 
+void UEmotionSubsystem::InitializeEmotionComponents(const TArray<UEmotionComponent*>& Components, UEmotionArchetype* Archetype)
+{
+	// Shared library and baseline, resolved once for the whole crowd
+	UEmotionLibrary* SharedLibrary = Archetype && Archetype->EmotionLibrary ? Archetype->EmotionLibrary.Get() : GetDefaultEmotionLibrary();
+	const FEmotionStateData* Baseline = Archetype ? Archetype->GetBaselineState(SharedLibrary) : nullptr;
+	const bool bShareBaseline = Baseline && Baseline->IsAtRest();
+	
+	RegisteredComponents.Reserve(RegisteredComponents.Num() + Components.Num());
+	RegisteredComponentIndices.Reserve(RegisteredComponents.Num() + Components.Num());
+	
+	// Pooled components that need a state of their own, allocated together below
+	TArray<UEmotionComponent*> PooledComponents;
+	PooledComponents.Reserve(Components.Num());
+	
+	for (UEmotionComponent* Component : Components)
+	{
+		if (!Component || Component->IsEmotionStateInitialized())
+		{
+			RegisterEmotionComponent(Component);
+			continue;
+		}
+		
+		if (Archetype)
+		{
+			Component->SetArchetype(Archetype);
+		}
+		
+		if (Component->WantsPooledState() && !Component->HasOwnEmotionLibrary() && !bShareBaseline && SharedLibrary)
+		{
+			PooledComponents.Add(Component);
+		}
+		else
+		{
+			// Own library or standalone state, nothing to share with the rest of the crowd
+			Component->InitializeEmotionState();
+		}
+		
+		RegisterEmotionComponent(Component);
+	}
+	
+	if (PooledComponents.Num() == 0)
+	{
+		return;
+	}
+	
+	FEmotionStateData Source;
+	if (Baseline)
+	{
+		Source = *Baseline;
+	}
+	else
+	{
+		Source.Initialize(SharedLibrary);
+	}
+	
+	TArray<FEmotionStateHandle> Handles;
+	StatePool.AllocateCopies(Source, GetWorld()->GetTimeSeconds(), PooledComponents.Num(), Handles);
+	PooledStateLibraries.Add(SharedLibrary);
+	PooledStateComponents.Reserve(PooledStateComponents.Num() + PooledComponents.Num());
+	PooledStateComponentIndices.Reserve(PooledStateComponents.Num() + PooledComponents.Num());
+	
+	for (int32 Index = 0; Index < PooledComponents.Num(); ++Index)
+	{
+		AddIndexedComponent(PooledStateComponents, PooledStateComponentIndices, PooledComponents[Index]);
+		PooledComponents[Index]->AdoptPooledState(this, Handles[Index]);
+	}
+	
+	UE_LOG(LogTemp, Verbose, TEXT("Initialized %d EmotionComponents, %d with pooled states"), Components.Num(), PooledComponents.Num());
+}
+
 void UEmotionSubsystem::NotifyEmotionChanged(UEmotionComponent* Component, const FGameplayTag& EmotionTag, float Intensity)
 {
 	// This function can be used to react to emotion changes globally
@@ -72,6 +372,19 @@ void UEmotionSubsystem::NotifyEmotionChanged(UEmotionComponent* Component, const
 	}
 }
 
+void UEmotionSubsystem::NotifyEmotionsChanged(UEmotionComponent* Component, const TArray<FEmotionChange>& Changes)
+{
+	// Same global hook as NotifyEmotionChanged, called once per change set
+	if (Component)
+	{
+		for (const FEmotionChange& Change : Changes)
+		{
+			UE_LOG(LogTemp, Verbose, TEXT("%s emotion changed: %s = %.2f -> %.2f"), 
+				*Component->GetOwnerName(), *Change.EmotionTag.ToString(), Change.PreviousIntensity, Change.NewIntensity);
+		}
+	}
+}
+
 TArray<UEmotionComponent*> UEmotionSubsystem::GetAllEmotionComponents() const
 {
 	return GetValidComponents();
@@ -102,18 +415,41 @@ TArray<UEmotionComponent*> UEmotionSubsystem::FindComponentsWithEmotionTag(const
 
 TArray<UEmotionComponent*> UEmotionSubsystem::FindComponentsWithAnyEmotionTags(const FGameplayTagContainer& EmotionTags) const
 {
-	return FilterComponentsByTag([&EmotionTags](UEmotionComponent* Component) {
-		return Component->GetAllEmotionTags().HasAny(EmotionTags);
+	// Compile the query once, components sharing a library reuse the same mask
+	const FEmotionTagQueryMask Query(EmotionTags);
+	return FilterComponentsByTag([&Query](UEmotionComponent* Component) {
+		return Component->MatchesAnyEmotionTags(Query);
 	});
 }
 
 TArray<UEmotionComponent*> UEmotionSubsystem::FindComponentsWithAllEmotionTags(const FGameplayTagContainer& EmotionTags) const
 {
-	return FilterComponentsByTag([&EmotionTags](UEmotionComponent* Component) {
-		return Component->GetAllEmotionTags().HasAll(EmotionTags);
+	const FEmotionTagQueryMask Query(EmotionTags);
+	return FilterComponentsByTag([&Query](UEmotionComponent* Component) {
+		return Component->MatchesAllEmotionTags(Query);
 	});
 }
 
+TMap<uint32, TArray<UEmotionComponent*>> UEmotionSubsystem::GroupComponentsByEmotionTagSet() const
+{
+	TMap<uint32, TArray<UEmotionComponent*>> Result;
+	
+	for (const TWeakObjectPtr<UEmotionComponent>& WeakComponent : RegisteredComponents)
+	{
+		if (UEmotionComponent* Component = WeakComponent.Get())
+		{
+			Result.FindOrAdd(Component->GetEmotionTagSetId()).Add(Component);
+		}
+	}
+	
+	return Result;
+}
+
+FEmotionTagSetStats UEmotionSubsystem::GetEmotionTagSetStats() const
+{
+	return FEmotionTagSetTable::Get().GetStats();
+}
+
 UEmotionComponent* UEmotionSubsystem::FindClosestComponentWithEmotionTag(const FGameplayTag& EmotionTag, const FVector& Location, float MaxDistance) const
 {
 	UEmotionComponent* ClosestComponent = nullptr;
@@ -289,6 +625,7 @@ UEmotionLibrary* UEmotionSubsystem::GetDefaultEmotionLibrary() const
 void UEmotionSubsystem::SetDefaultEmotionLibrary(UEmotionLibrary* NewLibrary)
 {
 	DefaultEmotionLibrary = NewLibrary;
+	bDefaultEmotionLibraryOverridden = true;
 }
 
 void UEmotionSubsystem::DebugLogAllEmotions() const
@@ -334,6 +671,276 @@ void UEmotionSubsystem::DebugLogAllEmotions() const
 	UE_LOG(LogTemp, Log, TEXT("======================================"));
 }
 
+FEmotionMemoryStats UEmotionSubsystem::GetMemoryStats() const
+{
+	FEmotionMemoryStats Stats;
+	Stats.NumPooledStates = StatePool.Num();
+	Stats.AgentStateBytes = StatePool.GetAllocatedSize();
+	Stats.QueueBytes = StatePool.GetScratchAllocatedSize() + PooledComponentsToUpdate.GetAllocatedSize();
+	Stats.IndexBytes = RegisteredComponents.GetAllocatedSize() + RegisteredComponentIndices.GetAllocatedSize()
+		+ PooledStateComponents.GetAllocatedSize() + PooledStateComponentIndices.GetAllocatedSize() + PooledStateLibraries.GetAllocatedSize();
+	Stats.TagSetBytes = GetEmotionTagSetStats().InternedBytes;
+	
+	TSet<const UEmotionLibrary*> Libraries;
+	TSet<const UEmotionArchetype*> Archetypes;
+	Libraries.Add(DefaultEmotionLibrary);
+	for (const UEmotionLibrary* Library : PooledStateLibraries)
+	{
+		Libraries.Add(Library);
+	}
+	
+	for (const TWeakObjectPtr<UEmotionComponent>& WeakComponent : RegisteredComponents)
+	{
+		const UEmotionComponent* Component = WeakComponent.Get();
+		if (!Component)
+		{
+			continue;
+		}
+		
+		++Stats.NumAgents;
+		
+		// Pooled slots are already part of the pool
+		SIZE_T OwnedBytes, PooledBytes, QueueBytes;
+		Component->GetEmotionMemoryUsage(OwnedBytes, PooledBytes, QueueBytes);
+		Stats.AgentStateBytes += OwnedBytes;
+		Stats.QueueBytes += QueueBytes;
+		
+		if (const FEmotionStateData* StateData = Component->GetStateData())
+		{
+			Libraries.Add(StateData->GetEmotionLibrary());
+		}
+		Archetypes.Add(Component->GetArchetype());
+	}
+	
+	for (const UEmotionLibrary* Library : Libraries)
+	{
+		Stats.LibraryBytes += Library ? Library->GetLibraryAllocatedSize() : 0;
+	}
+	for (const UEmotionArchetype* Archetype : Archetypes)
+	{
+		Stats.AgentStateBytes += Archetype ? Archetype->GetBaselineAllocatedSize() : 0;
+	}
+	
+	return Stats;
+}
+
+void UEmotionSubsystem::UpdateMemoryStats() const
+{
+	const FEmotionMemoryStats Stats = GetMemoryStats();
+	SET_MEMORY_STAT(STAT_EmotionLibraryMemory, Stats.LibraryBytes);
+	SET_MEMORY_STAT(STAT_EmotionAgentStateMemory, Stats.AgentStateBytes);
+	SET_MEMORY_STAT(STAT_EmotionIndexMemory, Stats.IndexBytes);
+	SET_MEMORY_STAT(STAT_EmotionQueueMemory, Stats.QueueBytes);
+	SET_MEMORY_STAT(STAT_EmotionTagSetMemory, Stats.TagSetBytes);
+	SET_DWORD_STAT(STAT_EmotionAgents, Stats.NumAgents);
+	SET_DWORD_STAT(STAT_EmotionPooledStates, Stats.NumPooledStates);
+}
+
+void UEmotionSubsystem::DebugBenchmarkClosestEmotion(int32 NumQueries) const
+{
+	const UEmotionLibrary* Library = GetDefaultEmotionLibrary();
+	if (!Library)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("EmotionSubsystem - No default emotion library to benchmark"));
+		return;
+	}
+	
+	const FEmotionSpatialIndex& SpatialIndex = Library->GetSpatialIndex();
+	if (SpatialIndex.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("EmotionSubsystem - %s has no emotions to benchmark"), *Library->GetName());
+		return;
+	}
+	
+	// The same points for every method, spread over the VA plane and slightly beyond it
+	NumQueries = FMath::Max(NumQueries, 1);
+	FRandomStream Random(0x454D4F);
+	TArray<FVector2D> Points;
+	Points.Reserve(NumQueries);
+	for (int32 Index = 0; Index < NumQueries; ++Index)
+	{
+		Points.Emplace(Random.FRandRange(-1.1f, 1.1f), Random.FRandRange(-1.1f, 1.1f));
+	}
+	
+	auto TimeQueries = [&Points](auto&& FindNearest, TArray<int32>& OutResults)
+	{
+		OutResults.SetNumUninitialized(Points.Num());
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < Points.Num(); ++Index)
+		{
+			OutResults[Index] = FindNearest(Points[Index]);
+		}
+		return (FPlatformTime::Seconds() - StartTime) * 1.0e9 / Points.Num();
+	};
+	
+	TArray<int32> ScanResults, ExactResults, ApproximateResults;
+	const double ScanTime = TimeQueries([&SpatialIndex](const FVector2D& Point) { return SpatialIndex.FindNearestBruteForce(Point); }, ScanResults);
+	const double ExactTime = TimeQueries([&SpatialIndex](const FVector2D& Point) { return SpatialIndex.FindNearest(Point); }, ExactResults);
+	const double ApproximateTime = TimeQueries([&SpatialIndex](const FVector2D& Point) { return SpatialIndex.FindNearestApproximate(Point); }, ApproximateResults);
+	
+	// Correctness against the scan is covered by the EmotionEngine.SpatialIndex.FindNearestMatchesScan automation test
+	UE_LOG(LogTemp, Log, TEXT("===== Closest Emotion Benchmark: %s ====="), *Library->GetName());
+	UE_LOG(LogTemp, Log, TEXT("%d emotions, %d queries, lookup grid %s"), SpatialIndex.Num(), NumQueries,
+		SpatialIndex.HasNearestGrid() ? TEXT("built") : TEXT("not built (small library, lookups scan)"));
+	UE_LOG(LogTemp, Log, TEXT("  Scan:        %8.1f ns/query"), ScanTime);
+	UE_LOG(LogTemp, Log, TEXT("  Exact:       %8.1f ns/query (%.1fx)"), ExactTime, ScanTime / FMath::Max(ExactTime, UE_SMALL_NUMBER));
+	UE_LOG(LogTemp, Log, TEXT("  Approximate: %8.1f ns/query (%.1fx)"), ApproximateTime, ScanTime / FMath::Max(ApproximateTime, UE_SMALL_NUMBER));
+}
+
+void UEmotionSubsystem::DebugBenchmarkPolarConversions(int32 NumCoordinates) const
+{
+	// The same inputs for both paths: angles from a few turns up to the 1e8 degrees NormalizeAngles is exact for,
+	// intensities including negative ones that both paths clamp, points slightly beyond the VA plane
+	NumCoordinates = FMath::Max(NumCoordinates, 1);
+	FRandomStream Random(0x504F4C);
+	TArray<float> Angles, Intensities, X, Y;
+	Angles.SetNumUninitialized(NumCoordinates);
+	Intensities.SetNumUninitialized(NumCoordinates);
+	X.SetNumUninitialized(NumCoordinates);
+	Y.SetNumUninitialized(NumCoordinates);
+	for (int32 Index = 0; Index < NumCoordinates; ++Index)
+	{
+		const float AngleMagnitude = Index % 2 == 0 ? Random.FRandRange(0.0f, 720.0f) : FMath::Pow(10.0f, Random.FRandRange(0.0f, 8.0f));
+		Angles[Index] = Random.FRand() < 0.5f ? -AngleMagnitude : AngleMagnitude;
+		Intensities[Index] = Random.FRandRange(-0.2f, 1.1f);
+		X[Index] = Random.FRandRange(-1.1f, 1.1f);
+		Y[Index] = Random.FRandRange(-1.1f, 1.1f);
+	}
+	
+	auto TimeConversions = [NumCoordinates](auto&& Convert)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		Convert();
+		return (FPlatformTime::Seconds() - StartTime) * 1.0e9 / NumCoordinates;
+	};
+	
+	TArray<float> ScalarAngles, BatchAngles;
+	ScalarAngles.SetNumUninitialized(NumCoordinates);
+	BatchAngles.SetNumUninitialized(NumCoordinates);
+	const double ScalarNormalizeTime = TimeConversions([&]()
+	{
+		for (int32 Index = 0; Index < NumCoordinates; ++Index)
+		{
+			ScalarAngles[Index] = UPolarCoordinateLibrary::NormalizeAngle(Angles[Index]);
+		}
+	});
+	const double BatchNormalizeTime = TimeConversions([&]() { FPolarCoordinateBatch::NormalizeAngles(Angles, BatchAngles); });
+	
+	TArray<FVector2D> ScalarCartesian;
+	TArray<float> BatchX, BatchY;
+	ScalarCartesian.SetNumUninitialized(NumCoordinates);
+	BatchX.SetNumUninitialized(NumCoordinates);
+	BatchY.SetNumUninitialized(NumCoordinates);
+	const double ScalarToCartesianTime = TimeConversions([&]()
+	{
+		for (int32 Index = 0; Index < NumCoordinates; ++Index)
+		{
+			ScalarCartesian[Index] = UPolarCoordinateLibrary::PolarToCartesian(UPolarCoordinateLibrary::MakePolarCoordinate(Angles[Index], Intensities[Index]));
+		}
+	});
+	const double BatchToCartesianTime = TimeConversions([&]() { FPolarCoordinateBatch::PolarToCartesian(Angles, Intensities, BatchX, BatchY); });
+	
+	TArray<FPolarCoordinate> ScalarPolar;
+	TArray<float> BatchIntensities;
+	ScalarPolar.SetNumUninitialized(NumCoordinates);
+	BatchIntensities.SetNumUninitialized(NumCoordinates);
+	const double ScalarToPolarTime = TimeConversions([&]()
+	{
+		for (int32 Index = 0; Index < NumCoordinates; ++Index)
+		{
+			ScalarPolar[Index] = UPolarCoordinateLibrary::CartesianToPolar(FVector2D(X[Index], Y[Index]));
+		}
+	});
+	const double BatchToPolarTime = TimeConversions([&]() { FPolarCoordinateBatch::CartesianToPolar(X, Y, BatchAngles, BatchIntensities); });
+	
+	auto Speedup = [](double ScalarTime, double BatchTime) { return ScalarTime / FMath::Max(BatchTime, UE_SMALL_NUMBER); };
+	
+	// The error bounds are checked by the EmotionEngine.PolarCoordinate.BatchErrorBounds automation test
+	UE_LOG(LogTemp, Log, TEXT("===== Polar Conversion Benchmark: %d coordinates ====="), NumCoordinates);
+	UE_LOG(LogTemp, Log, TEXT("  NormalizeAngle:   scalar %6.2f ns, batch %6.2f ns (%.1fx)"),
+		ScalarNormalizeTime, BatchNormalizeTime, Speedup(ScalarNormalizeTime, BatchNormalizeTime));
+	UE_LOG(LogTemp, Log, TEXT("  PolarToCartesian: scalar %6.2f ns, batch %6.2f ns (%.1fx)"),
+		ScalarToCartesianTime, BatchToCartesianTime, Speedup(ScalarToCartesianTime, BatchToCartesianTime));
+	UE_LOG(LogTemp, Log, TEXT("  CartesianToPolar: scalar %6.2f ns, batch %6.2f ns (%.1fx)"),
+		ScalarToPolarTime, BatchToPolarTime, Speedup(ScalarToPolarTime, BatchToPolarTime));
+}
+
+void UEmotionSubsystem::DebugLogMemoryReport(int32 NumTopAgents) const
+{
+	const FEmotionMemoryStats Stats = GetMemoryStats();
+	
+	UE_LOG(LogTemp, Log, TEXT("===== Emotion Memory Report ====="));
+	UE_LOG(LogTemp, Log, TEXT("Agents: %d (%d pooled states)"), Stats.NumAgents, Stats.NumPooledStates);
+	UE_LOG(LogTemp, Log, TEXT("  Libraries:    %8.1f KB"), Stats.LibraryBytes / 1024.0f);
+	UE_LOG(LogTemp, Log, TEXT("  Agent states: %8.1f KB"), Stats.AgentStateBytes / 1024.0f);
+	UE_LOG(LogTemp, Log, TEXT("  Indexes:      %8.1f KB"), Stats.IndexBytes / 1024.0f);
+	UE_LOG(LogTemp, Log, TEXT("  Queues:       %8.1f KB"), Stats.QueueBytes / 1024.0f);
+	UE_LOG(LogTemp, Log, TEXT("  Tag sets:     %8.1f KB"), Stats.TagSetBytes / 1024.0f);
+	UE_LOG(LogTemp, Log, TEXT("  Total:        %8.1f KB"), Stats.GetTotalBytes() / 1024.0f);
+	
+	struct FAgentMemory
+	{
+		const UEmotionComponent* Component;
+		SIZE_T Bytes;
+	};
+	
+	struct FArchetypeMemory
+	{
+		int32 NumAgents = 0;
+		int32 NumAtBaseline = 0;
+		SIZE_T Bytes = 0;
+	};
+	
+	TArray<FAgentMemory> Agents;
+	Agents.Reserve(RegisteredComponents.Num());
+	TMap<const UEmotionArchetype*, FArchetypeMemory> ArchetypeMemory;
+	
+	for (const TWeakObjectPtr<UEmotionComponent>& WeakComponent : RegisteredComponents)
+	{
+		if (const UEmotionComponent* Component = WeakComponent.Get())
+		{
+			SIZE_T OwnedBytes, PooledBytes, QueueBytes;
+			Component->GetEmotionMemoryUsage(OwnedBytes, PooledBytes, QueueBytes);
+			const SIZE_T Bytes = OwnedBytes + PooledBytes + QueueBytes;
+			Agents.Add({ Component, Bytes });
+			
+			FArchetypeMemory& Archetype = ArchetypeMemory.FindOrAdd(Component->GetArchetype());
+			++Archetype.NumAgents;
+			Archetype.NumAtBaseline += Component->IsAtArchetypeBaseline() ? 1 : 0;
+			Archetype.Bytes += Bytes;
+		}
+	}
+	
+	UE_LOG(LogTemp, Log, TEXT("By archetype:"));
+	for (const TPair<const UEmotionArchetype*, FArchetypeMemory>& Pair : ArchetypeMemory)
+	{
+		const SIZE_T BaselineBytes = Pair.Key ? Pair.Key->GetBaselineAllocatedSize() : 0;
+		UE_LOG(LogTemp, Log, TEXT("  %s: %d agents (%d at baseline), %.1f KB + %.1f KB baseline"),
+			Pair.Key ? *Pair.Key->GetName() : TEXT("None"), Pair.Value.NumAgents, Pair.Value.NumAtBaseline,
+			Pair.Value.Bytes / 1024.0f, BaselineBytes / 1024.0f);
+	}
+	
+	NumTopAgents = FMath::Min(FMath::Max(NumTopAgents, 0), Agents.Num());
+	if (NumTopAgents > 0)
+	{
+		Agents.Sort([](const FAgentMemory& A, const FAgentMemory& B) { return A.Bytes > B.Bytes; });
+		UE_LOG(LogTemp, Log, TEXT("Top %d agents:"), NumTopAgents);
+		for (int32 Index = 0; Index < NumTopAgents; ++Index)
+		{
+			UE_LOG(LogTemp, Log, TEXT("  %s: %llu bytes"), *Agents[Index].Component->GetOwnerName(), (uint64)Agents[Index].Bytes);
+		}
+	}
+	
+	UE_LOG(LogTemp, Log, TEXT("================================="));
+}
+
+void UEmotionSubsystem::DebugLogEmotionTagSetStats() const
+{
+	const FEmotionTagSetStats Stats = GetEmotionTagSetStats();
+	UE_LOG(LogTemp, Log, TEXT("EmotionSubsystem tag sets: %d sets shared by %d states, %.1f KB interned vs %.1f KB unshared (%.1f KB saved)"),
+		Stats.NumSets, Stats.NumReferences, Stats.InternedBytes / 1024.0f, Stats.UninternedBytes / 1024.0f, Stats.GetSavedBytes() / 1024.0f);
+}
+
 void UEmotionSubsystem::DebugVisualizeVACoordinates(float Duration) const
 {
 	// Only valid in a world context
@@ -409,12 +1016,19 @@ TArray<UEmotionComponent*> UEmotionSubsystem::FilterComponentsByTag(TFunctionRef
 {
 	TArray<UEmotionComponent*> Result;
 	
+	// Components with the same tag set id carry the same tags, so the answer is shared
+	TMap<uint32, bool> MatchesByTagSet;
+	
 	for (const TWeakObjectPtr<UEmotionComponent>& WeakComponent : RegisteredComponents)
 	{
 		if (WeakComponent.IsValid())
 		{
 			UEmotionComponent* Component = WeakComponent.Get();
-			if (Predicate(Component))
+			const uint32 TagSetId = Component->GetEmotionTagSetId();
+			
+			const bool* CachedMatch = MatchesByTagSet.Find(TagSetId);
+			const bool bMatches = CachedMatch ? *CachedMatch : MatchesByTagSet.Add(TagSetId, Predicate(Component));
+			if (bMatches)
 			{
 				Result.Add(Component);
 			}
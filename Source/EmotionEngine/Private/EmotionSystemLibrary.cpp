@@ -1,4 +1,5 @@
 #include "EmotionSystemLibrary.h"
+#include "EmotionEngineSettings.h"
 #include "Engine/AssetManager.h"
 #include "Kismet/GameplayStatics.h"
 
@@ -8,34 +9,98 @@ UEmotionLibrary* UEmotionSystemLibrary::GetLibraryOrDefault(UEmotionLibrary* Pro
     return ProvidedLibrary ? ProvidedLibrary : GetDefaultEmotionLibrary();
 }
 
+namespace EmotionSystemLibraryPrivate
+{
+    // Resolved path, empty until first asked for
+    static FSoftObjectPath DefaultLibraryPath;
+    static bool bDefaultLibraryPathResolved = false;
+
+    static TWeakObjectPtr<UEmotionLibrary> CachedDefaultLibrary;
+}
+
 UEmotionLibrary* UEmotionSystemLibrary::GetDefaultEmotionLibrary()
 {
-    // Try to find a default emotion library asset
-    // This assumes you'll create a default emotion library asset at this path
-    static const FSoftObjectPath DefaultEmotionLibraryPath(
-        TEXT("/EmotionEngine/EmotionSystem/DefaultEmotionLibrary.DefaultEmotionLibrary"));
+    using namespace EmotionSystemLibraryPrivate;
     
-    UEmotionLibrary* DefaultLibrary = Cast<UEmotionLibrary>(DefaultEmotionLibraryPath.TryLoad());
+    if (UEmotionLibrary* DefaultLibrary = CachedDefaultLibrary.Get())
+    {
+        return DefaultLibrary;
+    }
     
+    const FSoftObjectPath LibraryPath = GetDefaultEmotionLibraryPath();
+    if (LibraryPath.IsNull())
+    {
+        return nullptr;
+    }
+    
+    // Normally preloaded by the subsystem, loading here stalls the game thread
+    UEmotionLibrary* DefaultLibrary = Cast<UEmotionLibrary>(LibraryPath.ResolveObject());
     if (!DefaultLibrary)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("UEmotionSystemLibrary::GetDefaultEmotionLibrary - %s was not preloaded, loading it synchronously"), *LibraryPath.ToString());
+        DefaultLibrary = Cast<UEmotionLibrary>(LibraryPath.TryLoad());
+    }
+    
+    CachedDefaultLibrary = DefaultLibrary;
+    return DefaultLibrary;
+}
+
+FSoftObjectPath UEmotionSystemLibrary::GetDefaultEmotionLibraryPath()
+{
+    using namespace EmotionSystemLibraryPrivate;
+    
+    if (bDefaultLibraryPathResolved)
+    {
+        return DefaultLibraryPath;
+    }
+    bDefaultLibraryPathResolved = true;
+    
+    // Try to find a default emotion library asset
+    // This assumes you'll create a default emotion library asset at this path
+    DefaultLibraryPath = FSoftObjectPath(TEXT("/EmotionEngine/EmotionSystem/DefaultEmotionLibrary.DefaultEmotionLibrary"));
+    
+    IAssetRegistry& AssetRegistry = UAssetManager::Get().GetAssetRegistry();
+    if (!AssetRegistry.GetAssetByObjectPath(DefaultLibraryPath).IsValid())
     {
         // If no default library is found, try to find any emotion library
-        UAssetManager& AssetManager = UAssetManager::Get();
         TArray<FAssetData> AssetData;
         
         FARFilter Filter;
-        Filter.ClassPaths.Add(FTopLevelAssetPath(UEmotionLibrary::StaticClass()->GetClassPathName().ToString()));
+        Filter.ClassPaths.Add(UEmotionLibrary::StaticClass()->GetClassPathName());
         Filter.bRecursiveClasses = true;
         
-        AssetManager.GetAssetRegistry().GetAssets(Filter, AssetData);
-        
-        if (AssetData.Num() > 0)
-        {
-            DefaultLibrary = Cast<UEmotionLibrary>(AssetData[0].GetAsset());
-        }
+        AssetRegistry.GetAssets(Filter, AssetData);
+        DefaultLibraryPath = AssetData.Num() > 0 ? AssetData[0].GetSoftObjectPath() : FSoftObjectPath();
     }
     
-    return DefaultLibrary;
+    return DefaultLibraryPath;
+}
+
+void UEmotionSystemLibrary::InvalidateDefaultEmotionLibrary()
+{
+    using namespace EmotionSystemLibraryPrivate;
+    
+    DefaultLibraryPath.Reset();
+    bDefaultLibraryPathResolved = false;
+    CachedDefaultLibrary.Reset();
+}
+
+TSharedPtr<FStreamableHandle> UEmotionSystemLibrary::LoadEmotionLibraryAsync(const FSoftObjectPath& LibraryPath, FStreamableDelegate OnLoaded)
+{
+    if (LibraryPath.IsNull())
+    {
+        return nullptr;
+    }
+    
+    UAssetManager& AssetManager = UAssetManager::Get();
+    const FPrimaryAssetId LibraryId = AssetManager.GetPrimaryAssetIdForPath(LibraryPath);
+    if (LibraryId.IsValid())
+    {
+        // The asset manager keeps primary assets loaded until they are unloaded, with the requested bundles
+        return AssetManager.LoadPrimaryAsset(LibraryId, GetDefault<UEmotionEngineSettings>()->LibraryLoadBundles, MoveTemp(OnLoaded));
+    }
+    
+    return UAssetManager::GetStreamableManager().RequestAsyncLoad(LibraryPath, MoveTemp(OnLoaded));
 }
 
 UEmotionState* UEmotionSystemLibrary::CreateEmotionState(UEmotionLibrary* EmotionLibrary)
@@ -138,16 +203,13 @@ FVector2D UEmotionSystemLibrary::GetEmotionVACoordinate(const FGameplayTag& Emot
 {
     EmotionLibrary = GetLibraryOrDefault(EmotionLibrary);
     
+    FVector2D Coordinate = FVector2D::ZeroVector;
     if (EmotionLibrary && EmotionTag.IsValid())
     {
-        UEmotionDefinition* EmotionData = EmotionLibrary->GetEmotionByTag(EmotionTag);
-        if (EmotionData)
-        {
-            return EmotionData->GetEmotionCoordinate();
-        }
+        EmotionLibrary->GetEmotionCoordinate(EmotionTag, Coordinate);
     }
     
-    return FVector2D::ZeroVector;
+    return Coordinate;
 }
 
 TArray<UEmotionDefinition*> UEmotionSystemLibrary::GetEmotionsInRadius(const FVector2D& VACoordinate, float Radius, UEmotionLibrary* EmotionLibrary)
@@ -173,15 +235,10 @@ float UEmotionSystemLibrary::GetEmotionDistance(const FGameplayTag& EmotionTag1,
     
     if (EmotionLibrary && EmotionTag1.IsValid() && EmotionTag2.IsValid())
     {
-        UEmotionDefinition* Emotion1 = EmotionLibrary->GetEmotionByTag(EmotionTag1);
-        UEmotionDefinition* Emotion2 = EmotionLibrary->GetEmotionByTag(EmotionTag2);
-        
-        if (Emotion1 && Emotion2)
+        // Calculate distance between emotions in VA space
+        FVector2D VA1, VA2;
+        if (EmotionLibrary->GetEmotionCoordinate(EmotionTag1, VA1) && EmotionLibrary->GetEmotionCoordinate(EmotionTag2, VA2))
         {
-            // Calculate distance between emotions in VA space
-            FVector2D VA1 = Emotion1->GetEmotionCoordinate();
-            FVector2D VA2 = Emotion2->GetEmotionCoordinate();
-            
             return FVector2D::Distance(VA1, VA2);
         }
     }
@@ -211,7 +268,7 @@ FVector2D UEmotionSystemLibrary::GetStateVACoordinate(UEmotionState* EmotionStat
 {
     if (EmotionState)
     {
-        return EmotionState->VACoordinate;
+        return EmotionState->GetVACoordinate();
     }
     
     return FVector2D::ZeroVector;
@@ -221,36 +278,20 @@ void UEmotionSystemLibrary::SetStateVACoordinate(UEmotionState* EmotionState, co
 {
     if (EmotionState)
     {
-        EmotionState->VACoordinate = NewVACoordinate;
+        EmotionState->SetVACoordinate(NewVACoordinate);
     }
 }
 
-UEmotionDefinition* UEmotionSystemLibrary::FindClosestEmotion(const FVector2D& VACoordinate, UEmotionLibrary* EmotionLibrary)
+UEmotionDefinition* UEmotionSystemLibrary::FindClosestEmotion(const FVector2D& VACoordinate, UEmotionLibrary* EmotionLibrary, bool bApproximate)
 {
     EmotionLibrary = GetLibraryOrDefault(EmotionLibrary);
     
-    if (EmotionLibrary)
-    {
-        UEmotionDefinition* ClosestEmotion = nullptr;
-        float ClosestDistance = MAX_FLT;
-        
-        // Check all emotions in the library
-        for (UEmotionDefinition* EmotionData : EmotionLibrary->Emotions)
-        {
-            if (EmotionData)
-            {
-                float Distance = FVector2D::Distance(EmotionData->GetEmotionCoordinate(), VACoordinate);
-                
-                if (Distance < ClosestDistance)
-                {
-                    ClosestDistance = Distance;
-                    ClosestEmotion = EmotionData;
-                }
-            }
-        }
-        
-        return ClosestEmotion;
-    }
+    return EmotionLibrary ? EmotionLibrary->FindClosestEmotion(VACoordinate, bApproximate) : nullptr;
+}
+
+FEmotionZonePath UEmotionSystemLibrary::GetEmotionZonePath(const FVector2D& VACoordinate, UEmotionLibrary* EmotionLibrary)
+{
+    EmotionLibrary = GetLibraryOrDefault(EmotionLibrary);
     
-    return nullptr;
+    return EmotionLibrary ? EmotionLibrary->GetEmotionZonePath(VACoordinate) : FEmotionZonePath();
 }
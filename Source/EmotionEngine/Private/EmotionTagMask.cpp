@@ -0,0 +1,117 @@
+#include "EmotionTagMask.h"
+
+void FEmotionTagSpace::Reset()
+{
+    TagToIndex.Reset();
+    Closures.Reset();
+    bIsValid = false;
+}
+
+void FEmotionTagSpace::Build(TConstArrayView<FGameplayTag> SourceTags)
+{
+    Reset();
+
+    for (const FGameplayTag& SourceTag : SourceTags)
+    {
+        if (!SourceTag.IsValid() || TagToIndex.Contains(SourceTag))
+        {
+            continue;
+        }
+
+        // GetGameplayTagParents returns the tag itself followed by every parent
+        const FGameplayTagContainer Parents = SourceTag.GetGameplayTagParents();
+        for (const FGameplayTag& Tag : Parents)
+        {
+            if (!TagToIndex.Contains(Tag))
+            {
+                TagToIndex.Add(Tag, TagToIndex.Num());
+            }
+        }
+    }
+
+    if (TagToIndex.Num() > FEmotionTagMask::NumBits)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("FEmotionTagSpace::Build - %d tags exceed the %d bit mask width, falling back to tag containers"),
+            TagToIndex.Num(), FEmotionTagMask::NumBits);
+        Reset();
+        return;
+    }
+
+    // Closure of each tag is its own bit plus all of its parents' bits
+    Closures.SetNum(TagToIndex.Num());
+    for (const TPair<FGameplayTag, int32>& Pair : TagToIndex)
+    {
+        FEmotionTagMask& Closure = Closures[Pair.Value];
+        for (const FGameplayTag& Tag : Pair.Key.GetGameplayTagParents())
+        {
+            Closure.SetBit(TagToIndex.FindChecked(Tag));
+        }
+    }
+
+    bIsValid = true;
+}
+
+void FEmotionTagSpace::AppendTag(FEmotionTagMask& Mask, const FGameplayTag& Tag) const
+{
+    // Walk up until we reach a tag known to the space, its closure covers the remaining parents
+    for (FGameplayTag Current = Tag; Current.IsValid(); Current = Current.RequestDirectParent())
+    {
+        if (const int32* Index = TagToIndex.Find(Current))
+        {
+            Mask |= Closures[*Index];
+            return;
+        }
+    }
+}
+
+FEmotionTagMask FEmotionTagSpace::MakeMask(const FGameplayTagContainer& Tags) const
+{
+    FEmotionTagMask Mask;
+    for (const FGameplayTag& Tag : Tags)
+    {
+        AppendTag(Mask, Tag);
+    }
+    return Mask;
+}
+
+FEmotionTagMask FEmotionTagSpace::MakeQueryMask(const FGameplayTagContainer& Tags, bool& bOutComplete) const
+{
+    FEmotionTagMask Mask;
+    bOutComplete = true;
+    for (const FGameplayTag& Tag : Tags)
+    {
+        const int32 Index = GetTagIndex(Tag);
+        if (Index != INDEX_NONE)
+        {
+            Mask.SetBit(Index);
+        }
+        else
+        {
+            bOutComplete = false;
+        }
+    }
+    return Mask;
+}
+
+void FEmotionTagQueryMask::CompileFor(const FEmotionTagSpace& Space) const
+{
+    if (CachedSpace != &Space)
+    {
+        CachedMask = Space.MakeQueryMask(Tags, bCachedComplete);
+        CachedSpace = &Space;
+    }
+}
+
+bool FEmotionTagQueryMask::MatchesAny(const FEmotionTagSpace& Space, const FEmotionTagMask& AgentMask) const
+{
+    CompileFor(Space);
+    return AgentMask.HasAny(CachedMask);
+}
+
+bool FEmotionTagQueryMask::MatchesAll(const FEmotionTagSpace& Space, const FEmotionTagMask& AgentMask) const
+{
+    CompileFor(Space);
+
+    // A query tag outside the space can never be carried by an agent of this library
+    return bCachedComplete && AgentMask.HasAll(CachedMask);
+}
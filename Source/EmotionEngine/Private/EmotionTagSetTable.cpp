@@ -0,0 +1,185 @@
+#include "EmotionTagSetTable.h"
+#include "EmotionData.h"
+#include "EmotionEngine.h"
+
+bool FEmotionTagSet::HasCurrentMask(const UEmotionLibrary* InLibrary) const
+{
+    return bHasMask && InLibrary && InLibrary == Library && InLibrary->GetCompileId() == LibraryCompileId;
+}
+
+FEmotionTagSetRef::FEmotionTagSetRef(const FEmotionTagSetRef& Other)
+    : Id(Other.Id)
+{
+    FEmotionTagSetTable::Get().AddRef(Id);
+}
+
+FEmotionTagSetRef::FEmotionTagSetRef(FEmotionTagSetRef&& Other)
+    : Id(Other.Id)
+{
+    Other.Id = FEmotionTagSetTable::EmptySetId;
+}
+
+FEmotionTagSetRef& FEmotionTagSetRef::operator=(const FEmotionTagSetRef& Other)
+{
+    if (Id != Other.Id)
+    {
+        FEmotionTagSetTable::Get().AddRef(Other.Id);
+        FEmotionTagSetTable::Get().Release(Id);
+        Id = Other.Id;
+    }
+    return *this;
+}
+
+FEmotionTagSetRef& FEmotionTagSetRef::operator=(FEmotionTagSetRef&& Other)
+{
+    if (this != &Other)
+    {
+        FEmotionTagSetTable::Get().Release(Id);
+        Id = Other.Id;
+        Other.Id = FEmotionTagSetTable::EmptySetId;
+    }
+    return *this;
+}
+
+FEmotionTagSetRef::~FEmotionTagSetRef()
+{
+    FEmotionTagSetTable::Get().Release(Id);
+}
+
+const FEmotionTagSet& FEmotionTagSetRef::Get() const
+{
+    return FEmotionTagSetTable::Get().GetSet(Id);
+}
+
+void FEmotionTagSetRef::Reset()
+{
+    FEmotionTagSetTable::Get().Release(Id);
+    Id = FEmotionTagSetTable::EmptySetId;
+}
+
+FEmotionTagSetTable& FEmotionTagSetTable::Get()
+{
+    // Never destroyed, references held by objects torn down during shutdown must still resolve
+    static FEmotionTagSetTable* Table = new FEmotionTagSetTable();
+    return *Table;
+}
+
+FEmotionTagSetTable::FEmotionTagSetTable()
+{
+    // Id 0 is the empty set shared by every library
+    Sets.Add(MakeUnique<FEmotionTagSet>());
+}
+
+uint32 FEmotionTagSetTable::HashTagSet(const UEmotionLibrary* Library, const FGameplayTagContainer& Tags)
+{
+    // Summing keeps the hash independent of the order the tags were added in, same as container equality
+    uint32 TagsHash = 0;
+    for (const FGameplayTag& Tag : Tags)
+    {
+        TagsHash += GetTypeHash(Tag) * 0x9E3779B1u;
+    }
+    return HashCombine(GetTypeHash(Library), TagsHash);
+}
+
+FEmotionTagSetRef FEmotionTagSetTable::Intern(const UEmotionLibrary* Library, const FGameplayTagContainer& Tags)
+{
+    if (Tags.IsEmpty())
+    {
+        return FEmotionTagSetRef();
+    }
+
+    check(IsInGameThread());
+    LLM_SCOPE_BYTAG(EmotionEngine);
+
+    // Sets interned before the library recompiled keep masks in the old tag space and are not shared anymore
+    const uint32 CompileId = Library ? Library->GetCompileId() : 0;
+    const uint32 Hash = HashTagSet(Library, Tags);
+    for (auto It = IdsByHash.CreateConstKeyIterator(Hash); It; ++It)
+    {
+        FEmotionTagSet& Set = *Sets[It.Value()];
+        if (Set.Library == Library && Set.LibraryCompileId == CompileId && Set.Tags == Tags)
+        {
+            ++Set.RefCount;
+            return FEmotionTagSetRef(It.Value());
+        }
+    }
+
+    uint32 Id;
+    if (FreeIds.Num() > 0)
+    {
+        Id = FreeIds.Pop();
+    }
+    else
+    {
+        Id = Sets.Add(MakeUnique<FEmotionTagSet>());
+    }
+
+    FEmotionTagSet& Set = *Sets[Id];
+    Set.Tags = Tags;
+    Set.Library = Library;
+    Set.LibraryCompileId = CompileId;
+    Set.Hash = Hash;
+    Set.RefCount = 1;
+    Set.bHasMask = Library && Library->GetTagSpace().IsValid();
+    Set.Mask = Set.bHasMask ? Library->GetTagSpace().MakeMask(Tags) : FEmotionTagMask();
+    IdsByHash.Add(Hash, Id);
+    return FEmotionTagSetRef(Id);
+}
+
+const FEmotionTagSet& FEmotionTagSetTable::GetSet(uint32 Id) const
+{
+    checkSlow(Sets.IsValidIndex(Id));
+    return *Sets[Id];
+}
+
+void FEmotionTagSetTable::AddRef(uint32 Id)
+{
+    check(IsInGameThread());
+    if (Id != EmptySetId)
+    {
+        ++Sets[Id]->RefCount;
+    }
+}
+
+void FEmotionTagSetTable::Release(uint32 Id)
+{
+    check(IsInGameThread());
+    if (Id == EmptySetId)
+    {
+        return;
+    }
+
+    FEmotionTagSet& Set = *Sets[Id];
+    check(Set.RefCount > 0);
+    if (--Set.RefCount == 0)
+    {
+        IdsByHash.RemoveSingle(Set.Hash, Id);
+        Set.Tags.Reset();
+        Set.Library = nullptr;
+        Set.LibraryCompileId = 0;
+        FreeIds.Add(Id);
+    }
+}
+
+FEmotionTagSetStats FEmotionTagSetTable::GetStats() const
+{
+    FEmotionTagSetStats Stats;
+    Stats.InternedBytes = Sets.GetAllocatedSize() + FreeIds.GetAllocatedSize() + IdsByHash.GetAllocatedSize();
+
+    for (const TUniquePtr<FEmotionTagSet>& Set : Sets)
+    {
+        // Tag arrays only, the parent tag cache of a container is not exposed
+        const SIZE_T TagBytes = Set->Tags.GetGameplayTagArray().GetAllocatedSize();
+        Stats.InternedBytes += sizeof(FEmotionTagSet) + TagBytes;
+
+        if (Set->RefCount > 0)
+        {
+            ++Stats.NumSets;
+            Stats.NumReferences += Set->RefCount;
+            Stats.InternedBytes += Set->RefCount * sizeof(FEmotionTagSetRef);
+            Stats.UninternedBytes += Set->RefCount * (sizeof(FGameplayTagContainer) + sizeof(FEmotionTagMask) + TagBytes);
+        }
+    }
+
+    return Stats;
+}
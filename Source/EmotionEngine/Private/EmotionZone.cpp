@@ -1,2 +1,267 @@
 #include "EmotionZone.h"
+#include "Algo/Compare.h"
+#include "Algo/Unique.h"
+#include "Async/ParallelFor.h"
 
+namespace EmotionZonePrivate
+{
+    // Core, range and variation
+    static constexpr int32 NumLevels = 3;
+
+    // Zone flattened for compilation, angles as pseudo angles
+    struct FCompileZone
+    {
+        // Start > End wraps past 0
+        float StartPseudoAngle = 0.0f;
+        float EndPseudoAngle = 0.0f;
+        bool bFullCircle = false;
+        float MinRadius = 0.0f;
+        float MaxRadius = 1.0f;
+        FGameplayTag Tag;
+
+        bool ContainsPseudoAngle(float PseudoAngle) const
+        {
+            if (bFullCircle)
+            {
+                return true;
+            }
+            return StartPseudoAngle <= EndPseudoAngle
+                ? PseudoAngle >= StartPseudoAngle && PseudoAngle < EndPseudoAngle
+                : PseudoAngle >= StartPseudoAngle || PseudoAngle < EndPseudoAngle;
+        }
+    };
+
+    static void GatherCompileZones(TConstArrayView<FEmotionZone> Zones, TArray<FCompileZone>& OutZones)
+    {
+        for (const FEmotionZone& Zone : Zones)
+        {
+            if (!Zone.EmotionTag.IsValid())
+            {
+                continue;
+            }
+
+            const FPolarCoordinateRange& Range = Zone.CoordinateRange;
+            FCompileZone& Compiled = OutZones.AddDefaulted_GetRef();
+            Compiled.bFullCircle = FMath::Abs(Range.EndAngle - Range.StartAngle) >= 360.0f;
+            Compiled.StartPseudoAngle = FEmotionZoneTable::DegreesToPseudoAngle(Range.StartAngle);
+            Compiled.EndPseudoAngle = FEmotionZoneTable::DegreesToPseudoAngle(Range.EndAngle);
+            Compiled.MinRadius = FMath::Clamp(Range.MinRadius, 0.0f, 1.0f);
+            Compiled.MaxRadius = FMath::Clamp(Range.MaxRadius, Compiled.MinRadius, 1.0f);
+            Compiled.Tag = Zone.EmotionTag;
+        }
+    }
+}
+
+// FEmotionZoneTable implementation
+float FEmotionZoneTable::GetPseudoAngle(const FVector2D& Direction)
+{
+    const float X = static_cast<float>(Direction.X);
+    const float Y = static_cast<float>(Direction.Y);
+    if (FMath::Abs(X) + FMath::Abs(Y) <= UE_SMALL_NUMBER)
+    {
+        return 0.0f;
+    }
+
+    // One quadrant per unit, the position inside a quadrant is the ratio of the coordinates
+    float PseudoAngle;
+    if (Y >= 0.0f)
+    {
+        PseudoAngle = X >= 0.0f ? Y / (X + Y) : 1.0f - X / (Y - X);
+    }
+    else
+    {
+        PseudoAngle = X < 0.0f ? 2.0f - Y / (-X - Y) : 3.0f + X / (X - Y);
+    }
+
+    // Rounding just below the positive X axis can reach 4
+    return PseudoAngle < 4.0f ? PseudoAngle : 0.0f;
+}
+
+float FEmotionZoneTable::DegreesToPseudoAngle(float Degrees)
+{
+    float Sin, Cos;
+    FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(UPolarCoordinateLibrary::NormalizeAngle(Degrees)));
+    return GetPseudoAngle(FVector2D(Cos, Sin));
+}
+
+void FEmotionZoneTable::Reset()
+{
+    Segments.Reset();
+    Bands.Reset();
+    BucketSegments.Reset();
+}
+
+SIZE_T FEmotionZoneTable::GetAllocatedSize() const
+{
+    return Segments.GetAllocatedSize() + Bands.GetAllocatedSize() + BucketSegments.GetAllocatedSize();
+}
+
+void FEmotionZoneTable::Build(TConstArrayView<FEmotionZone> CoreZones, TConstArrayView<FEmotionZone> RangeZones, TConstArrayView<FEmotionZone> VariationZones)
+{
+    using namespace EmotionZonePrivate;
+
+    Reset();
+
+    TArray<FCompileZone> Levels[NumLevels];
+    GatherCompileZones(CoreZones, Levels[0]);
+    GatherCompileZones(RangeZones, Levels[1]);
+    GatherCompileZones(VariationZones, Levels[2]);
+    if (Levels[0].Num() + Levels[1].Num() + Levels[2].Num() == 0)
+    {
+        return;
+    }
+
+    // Cut the wheel at every zone edge, no zone starts or ends inside a segment
+    TArray<float> AngleEdges = { 0.0f, 4.0f };
+    for (const TArray<FCompileZone>& Level : Levels)
+    {
+        for (const FCompileZone& Zone : Level)
+        {
+            if (!Zone.bFullCircle)
+            {
+                AngleEdges.Add(Zone.StartPseudoAngle);
+                AngleEdges.Add(Zone.EndPseudoAngle);
+            }
+        }
+    }
+    AngleEdges.Sort();
+    AngleEdges.SetNum(Algo::Unique(AngleEdges));
+
+    TArray<float> RadiusEdges;
+    TArray<FBand> SegmentBands;
+    for (int32 EdgeIndex = 0; EdgeIndex + 1 < AngleEdges.Num(); ++EdgeIndex)
+    {
+        const float SegmentAngle = (AngleEdges[EdgeIndex] + AngleEdges[EdgeIndex + 1]) * 0.5f;
+
+        // Cut the segment at the radius edges of the zones covering it
+        RadiusEdges.Reset();
+        RadiusEdges.Add(0.0f);
+        RadiusEdges.Add(1.0f);
+        for (const TArray<FCompileZone>& Level : Levels)
+        {
+            for (const FCompileZone& Zone : Level)
+            {
+                if (Zone.ContainsPseudoAngle(SegmentAngle))
+                {
+                    RadiusEdges.Add(Zone.MinRadius);
+                    RadiusEdges.Add(Zone.MaxRadius);
+                }
+            }
+        }
+        RadiusEdges.Sort();
+        RadiusEdges.SetNum(Algo::Unique(RadiusEdges));
+
+        SegmentBands.Reset();
+        for (int32 RadiusIndex = 0; RadiusIndex + 1 < RadiusEdges.Num(); ++RadiusIndex)
+        {
+            const float BandRadius = (RadiusEdges[RadiusIndex] + RadiusEdges[RadiusIndex + 1]) * 0.5f;
+
+            FEmotionZonePath Path;
+            FGameplayTag* LevelTags[] = { &Path.CoreTag, &Path.RangeTag, &Path.VariationTag };
+            for (int32 LevelIndex = 0; LevelIndex < NumLevels; ++LevelIndex)
+            {
+                const FCompileZone* Zone = Levels[LevelIndex].FindByPredicate([SegmentAngle, BandRadius](const FCompileZone& Candidate)
+                {
+                    return Candidate.ContainsPseudoAngle(SegmentAngle) && BandRadius >= Candidate.MinRadius && BandRadius <= Candidate.MaxRadius;
+                });
+                if (Zone)
+                {
+                    *LevelTags[LevelIndex] = Zone->Tag;
+                }
+            }
+
+            // Neighboring bands with the same path merge
+            const float MaxRadiusSquared = FMath::Square(RadiusEdges[RadiusIndex + 1]);
+            if (SegmentBands.Num() > 0 && SegmentBands.Last().Path == Path)
+            {
+                SegmentBands.Last().MaxRadiusSquared = MaxRadiusSquared;
+            }
+            else
+            {
+                SegmentBands.Add({ MaxRadiusSquared, Path });
+            }
+        }
+
+        // The outermost band extends past the rim
+        SegmentBands.Last().MaxRadiusSquared = MAX_flt;
+
+        // Neighboring segments with the same bands merge, so a cone without ranges or variations is one segment
+        const bool bSameAsPrevious = Segments.Num() > 0 && Segments.Last().NumBands == SegmentBands.Num()
+            && Algo::Compare(MakeArrayView(Bands.GetData() + Segments.Last().FirstBand, Segments.Last().NumBands), SegmentBands,
+                [](const FBand& A, const FBand& B) { return A.MaxRadiusSquared == B.MaxRadiusSquared && A.Path == B.Path; });
+        if (bSameAsPrevious)
+        {
+            Segments.Last().EndPseudoAngle = AngleEdges[EdgeIndex + 1];
+        }
+        else
+        {
+            Segments.Add({ AngleEdges[EdgeIndex + 1], Bands.Num(), SegmentBands.Num() });
+            Bands.Append(SegmentBands);
+        }
+    }
+
+    BucketSegments.SetNumUninitialized(NumAngleBuckets);
+    int32 SegmentIndex = 0;
+    for (int32 Bucket = 0; Bucket < NumAngleBuckets; ++Bucket)
+    {
+        const float BucketStart = Bucket * (4.0f / NumAngleBuckets);
+        while (BucketStart >= Segments[SegmentIndex].EndPseudoAngle)
+        {
+            ++SegmentIndex;
+        }
+        BucketSegments[Bucket] = SegmentIndex;
+    }
+}
+
+FEmotionZonePath FEmotionZoneTable::Classify(const FVector2D& Coordinate) const
+{
+    if (Segments.Num() == 0)
+    {
+        return FEmotionZonePath();
+    }
+
+    const float PseudoAngle = GetPseudoAngle(Coordinate);
+    const int32 Bucket = FMath::Min(FMath::FloorToInt32(PseudoAngle * (NumAngleBuckets / 4.0f)), NumAngleBuckets - 1);
+
+    // Only the edges falling inside the bucket are compared
+    int32 SegmentIndex = BucketSegments[Bucket];
+    while (PseudoAngle >= Segments[SegmentIndex].EndPseudoAngle && SegmentIndex + 1 < Segments.Num())
+    {
+        ++SegmentIndex;
+    }
+
+    // The last band of a segment is unbounded, the scan always stops
+    const float RadiusSquared = static_cast<float>(Coordinate.SizeSquared());
+    const FBand* Band = Bands.GetData() + Segments[SegmentIndex].FirstBand;
+    while (RadiusSquared > Band->MaxRadiusSquared)
+    {
+        ++Band;
+    }
+    return Band->Path;
+}
+
+void FEmotionZoneTable::ClassifyBatch(TConstArrayView<FVector2D> Coordinates, TArrayView<FEmotionZonePath> OutPaths) const
+{
+    check(OutPaths.Num() >= Coordinates.Num());
+
+    auto ClassifyRange = [this, Coordinates, OutPaths](int32 Start, int32 End)
+    {
+        for (int32 Index = Start; Index < End; ++Index)
+        {
+            OutPaths[Index] = Classify(Coordinates[Index]);
+        }
+    };
+
+    if (Coordinates.Num() < MinParallelBatchSize)
+    {
+        ClassifyRange(0, Coordinates.Num());
+        return;
+    }
+
+    // The table is read only, chunks of the batch are classified independently
+    const int32 NumChunks = FMath::DivideAndRoundUp(Coordinates.Num(), MinParallelBatchSize);
+    ParallelFor(NumChunks, [&ClassifyRange, &Coordinates](int32 Chunk)
+    {
+        ClassifyRange(Chunk * MinParallelBatchSize, FMath::Min((Chunk + 1) * MinParallelBatchSize, Coordinates.Num()));
+    });
+}
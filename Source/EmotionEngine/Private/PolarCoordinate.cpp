@@ -1,5 +1,96 @@
 #include "PolarCoordinate.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "Math/VectorRegister.h"
+
+namespace PolarCoordinatePrivate
+{
+    // Odd minimax polynomial of atan on [0, 1], coefficients of Ratio, Ratio^3 ... Ratio^11, within 1.8e-6 radians
+    static constexpr int32 NumAtanCoefficients = 6;
+    static constexpr float AtanCoefficients[NumAtanCoefficients] = { 0.99997726f, -0.33262347f, 0.19354346f, -0.11643287f, 0.05265332f, -0.01172120f };
+
+    // Angle - 360 * floor(Angle / 360). The subtraction is exact, the quotient can land one turn off and is corrected.
+    static FORCEINLINE VectorRegister4Float NormalizeDegrees(const VectorRegister4Float& Angles)
+    {
+        const VectorRegister4Float FullCircle = VectorSetFloat1(360.0f);
+        const VectorRegister4Float Turns = VectorFloor(VectorMultiply(Angles, VectorSetFloat1(1.0f / 360.0f)));
+        VectorRegister4Float Result = VectorSubtract(Angles, VectorMultiply(Turns, FullCircle));
+        Result = VectorSelect(VectorCompareLT(Result, VectorZeroFloat()), VectorAdd(Result, FullCircle), Result);
+        return VectorSelect(VectorCompareGE(Result, FullCircle), VectorSubtract(Result, FullCircle), Result);
+    }
+
+    static FORCEINLINE void PolarToCartesian(const VectorRegister4Float& Angles, const VectorRegister4Float& Intensities,
+        VectorRegister4Float& OutX, VectorRegister4Float& OutY)
+    {
+        // [-180, 180) keeps VectorSinCos inside its first period
+        VectorRegister4Float Degrees = NormalizeDegrees(Angles);
+        Degrees = VectorSelect(VectorCompareGE(Degrees, VectorSetFloat1(180.0f)), VectorSubtract(Degrees, VectorSetFloat1(360.0f)), Degrees);
+        const VectorRegister4Float Radians = VectorMultiply(Degrees, VectorSetFloat1(UE_PI / 180.0f));
+
+        VectorRegister4Float Sin, Cos;
+        VectorSinCos(&Sin, &Cos, &Radians);
+
+        // Negative intensities land on the origin like MakePolarCoordinate, not on the mirrored point
+        const VectorRegister4Float Radii = VectorMax(Intensities, VectorZeroFloat());
+        OutX = VectorMultiply(Cos, Radii);
+        OutY = VectorMultiply(Sin, Radii);
+    }
+
+    static FORCEINLINE void CartesianToPolar(const VectorRegister4Float& X, const VectorRegister4Float& Y,
+        VectorRegister4Float& OutAngles, VectorRegister4Float& OutIntensities)
+    {
+        const VectorRegister4Float Zero = VectorZeroFloat();
+        const VectorRegister4Float AbsX = VectorAbs(X);
+        const VectorRegister4Float AbsY = VectorAbs(Y);
+
+        // atan of the smaller over the larger coordinate is the angle to the nearest axis, within [0, 45] degrees
+        const VectorRegister4Float Ratio = VectorDivide(VectorMin(AbsX, AbsY), VectorMax(VectorMax(AbsX, AbsY), VectorSetFloat1(MIN_flt)));
+        const VectorRegister4Float RatioSquared = VectorMultiply(Ratio, Ratio);
+        VectorRegister4Float Atan = VectorSetFloat1(AtanCoefficients[NumAtanCoefficients - 1]);
+        for (int32 Index = NumAtanCoefficients - 2; Index >= 0; --Index)
+        {
+            Atan = VectorMultiplyAdd(Atan, RatioSquared, VectorSetFloat1(AtanCoefficients[Index]));
+        }
+        VectorRegister4Float Degrees = VectorMultiply(VectorMultiply(Atan, Ratio), VectorSetFloat1(180.0f / UE_PI));
+
+        // Unfold the octant, then the half plane, then the sign like Atan2
+        Degrees = VectorSelect(VectorCompareGT(AbsY, AbsX), VectorSubtract(VectorSetFloat1(90.0f), Degrees), Degrees);
+        Degrees = VectorSelect(VectorCompareLT(X, Zero), VectorSubtract(VectorSetFloat1(180.0f), Degrees), Degrees);
+        Degrees = VectorSelect(VectorCompareLT(Y, Zero), VectorNegate(Degrees), Degrees);
+        Degrees = NormalizeDegrees(Degrees);
+
+        OutIntensities = VectorSqrt(VectorMultiplyAdd(X, X, VectorMultiply(Y, Y)));
+        OutAngles = VectorSelect(VectorCompareGT(OutIntensities, VectorSetFloat1(SMALL_NUMBER)), Degrees, Zero);
+    }
+
+    // Runs a kernel of two inputs and two outputs over blocks of four, the tail through zero padded copies so every
+    // value goes through the same math. Loads come before stores, outputs may alias the inputs of the same block.
+    template <typename KernelType>
+    static void RunBatch(const float* InA, const float* InB, float* OutA, float* OutB, int32 Num, KernelType Kernel)
+    {
+        VectorRegister4Float ResultA, ResultB;
+        int32 Index = 0;
+        for (; Index + 4 <= Num; Index += 4)
+        {
+            Kernel(VectorLoad(InA + Index), VectorLoad(InB + Index), ResultA, ResultB);
+            VectorStore(ResultA, OutA + Index);
+            VectorStore(ResultB, OutB + Index);
+        }
+
+        const int32 NumLeft = Num - Index;
+        if (NumLeft > 0)
+        {
+            float PaddedA[4] = {};
+            float PaddedB[4] = {};
+            FMemory::Memcpy(PaddedA, InA + Index, NumLeft * sizeof(float));
+            FMemory::Memcpy(PaddedB, InB + Index, NumLeft * sizeof(float));
+            Kernel(VectorLoad(PaddedA), VectorLoad(PaddedB), ResultA, ResultB);
+            VectorStore(ResultA, PaddedA);
+            VectorStore(ResultB, PaddedB);
+            FMemory::Memcpy(OutA + Index, PaddedA, NumLeft * sizeof(float));
+            FMemory::Memcpy(OutB + Index, PaddedB, NumLeft * sizeof(float));
+        }
+    }
+}
 
 bool FPolarCoordinateRange::ContainCartersianCoordinate(const FVector2D& Coordinate) const
 {
@@ -117,6 +208,56 @@ float FPolarCoordinateRange::GetStrengthForCartesianCoordinate(const FVector2D&
     return 1.0f - DistFromCenter;
 }
 
+// FPolarCoordinateBatch implementation
+
+void FPolarCoordinateBatch::NormalizeAngles(TConstArrayView<float> Angles, TArrayView<float> OutAngles)
+{
+    check(OutAngles.Num() == Angles.Num());
+
+    const int32 Num = Angles.Num();
+    const float* InAngles = Angles.GetData();
+    float* Out = OutAngles.GetData();
+
+    int32 Index = 0;
+    for (; Index + 4 <= Num; Index += 4)
+    {
+        VectorStore(PolarCoordinatePrivate::NormalizeDegrees(VectorLoad(InAngles + Index)), Out + Index);
+    }
+
+    const int32 NumLeft = Num - Index;
+    if (NumLeft > 0)
+    {
+        float Padded[4] = {};
+        FMemory::Memcpy(Padded, InAngles + Index, NumLeft * sizeof(float));
+        VectorStore(PolarCoordinatePrivate::NormalizeDegrees(VectorLoad(Padded)), Padded);
+        FMemory::Memcpy(Out + Index, Padded, NumLeft * sizeof(float));
+    }
+}
+
+void FPolarCoordinateBatch::PolarToCartesian(TConstArrayView<float> Angles, TConstArrayView<float> Intensities, TArrayView<float> OutX, TArrayView<float> OutY)
+{
+    const int32 Num = Angles.Num();
+    check(Intensities.Num() == Num && OutX.Num() == Num && OutY.Num() == Num);
+
+    PolarCoordinatePrivate::RunBatch(Angles.GetData(), Intensities.GetData(), OutX.GetData(), OutY.GetData(), Num,
+        [](const VectorRegister4Float& A, const VectorRegister4Float& B, VectorRegister4Float& OutA, VectorRegister4Float& OutB)
+        {
+            PolarCoordinatePrivate::PolarToCartesian(A, B, OutA, OutB);
+        });
+}
+
+void FPolarCoordinateBatch::CartesianToPolar(TConstArrayView<float> X, TConstArrayView<float> Y, TArrayView<float> OutAngles, TArrayView<float> OutIntensities)
+{
+    const int32 Num = X.Num();
+    check(Y.Num() == Num && OutAngles.Num() == Num && OutIntensities.Num() == Num);
+
+    PolarCoordinatePrivate::RunBatch(X.GetData(), Y.GetData(), OutAngles.GetData(), OutIntensities.GetData(), Num,
+        [](const VectorRegister4Float& A, const VectorRegister4Float& B, VectorRegister4Float& OutA, VectorRegister4Float& OutB)
+        {
+            PolarCoordinatePrivate::CartesianToPolar(A, B, OutA, OutB);
+        });
+}
+
 // UPolarCoordinateLibrary implementation
 
 float UPolarCoordinateLibrary::NormalizeAngle(float Angle)
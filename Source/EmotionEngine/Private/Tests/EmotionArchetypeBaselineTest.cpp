@@ -0,0 +1,86 @@
+#include "Misc/AutomationTest.h"
+#include "EmotionArchetype.h"
+#include "EmotionData.h"
+#include "EmotionStatePool.h"
+#include "EmotionTags.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEmotionArchetypeCollapseTest, "EmotionEngine.Archetype.DivergeDecayCollapse",
+    EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FEmotionArchetypeCollapseTest::RunTest(const FString& Parameters)
+{
+    static constexpr float DeltaTime = 1.0f / 60.0f;
+
+    // Long enough for the emotion to decay and the VA spring to settle back with the default spring settings
+    static constexpr float MaxSimulatedTime = 120.0f;
+
+    UEmotionLibrary* Library = NewObject<UEmotionLibrary>(GetTransientPackage());
+    UEmotionDefinition* Joy = NewObject<UEmotionDefinition>(Library);
+    Joy->Emotion.Tag = EmotionGameplayTags::Emotion_Core_Joy;
+    Joy->Emotion.DecayRate = 10.0f;
+    Library->Emotions.Add(Joy);
+    Library->BuildRuntimeData();
+
+    // No initial emotions at the neutral coordinate, the baseline agents can share
+    UEmotionArchetype* Archetype = NewObject<UEmotionArchetype>(GetTransientPackage());
+    const FEmotionStateData* Baseline = Archetype->GetBaselineState(Library);
+    if (!TestNotNull(TEXT("Baseline state"), Baseline))
+    {
+        return false;
+    }
+    TestTrue(TEXT("Baseline is at rest"), Baseline->IsAtRest());
+
+    // Runs Tick until the state is equivalent to the baseline again, returns the simulated time or a negative value
+    auto SimulateUntilCollapsed = [Baseline](TFunctionRef<void(float)> Tick, TFunctionRef<const FEmotionStateData&()> GetState)
+    {
+        for (float Time = DeltaTime; Time <= MaxSimulatedTime; Time += DeltaTime)
+        {
+            Tick(Time);
+            if (GetState().IsEquivalentTo(*Baseline))
+            {
+                return Time;
+            }
+        }
+        return -1.0f;
+    };
+
+    // Pooled state, the path crowds take and the one TryCollapseToArchetypeBaseline checks
+    {
+        FEmotionStatePool StatePool;
+        TArray<FEmotionStateHandle> Handles;
+        StatePool.AllocateCopies(*Baseline, 0.0f, 1, Handles);
+        FEmotionStateData* State = StatePool.Get(Handles[0]);
+        TestTrue(TEXT("Pooled copy starts equivalent to the baseline"), State->IsEquivalentTo(*Baseline));
+
+        State->AddEmotion(EmotionGameplayTags::Emotion_Core_Joy, 50.0f, 0.0f);
+        TestFalse(TEXT("Pooled state diverges on a change"), State->IsEquivalentTo(*Baseline));
+
+        const float CollapseTime = SimulateUntilCollapsed(
+            [&StatePool](float Time) { StatePool.Tick(DeltaTime, Time); },
+            [&StatePool, &Handles]() -> const FEmotionStateData& { return *StatePool.Get(Handles[0]); });
+        AddInfo(FString::Printf(TEXT("Pooled state collapsed after %.2f s"), CollapseTime));
+        TestTrue(TEXT("Pooled state returns to the baseline after decaying"), CollapseTime > 0.0f);
+        TestTrue(TEXT("Pooled state rests once collapsed"), StatePool.Get(Handles[0])->IsAtRest());
+    }
+
+    // Standalone state, pushed off the baseline coordinate without any emotion
+    {
+        FEmotionStateData State;
+        State.InitializeFromBaseline(*Baseline, 0.0f);
+        State.SetVACoordinate(FVector2D(0.5, -0.3));
+        TestFalse(TEXT("Standalone state diverges when its VA coordinate moves"), State.IsEquivalentTo(*Baseline));
+
+        const float CollapseTime = SimulateUntilCollapsed(
+            [&State](float Time) { State.Tick(DeltaTime, Time); },
+            [&State]() -> const FEmotionStateData& { return State; });
+        AddInfo(FString::Printf(TEXT("Standalone state collapsed after %.2f s"), CollapseTime));
+        TestTrue(TEXT("Standalone state springs back to the baseline"), CollapseTime > 0.0f);
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,105 @@
+#include "Misc/AutomationTest.h"
+#include "EmotionSpatialIndex.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEmotionSpatialIndexNearestTest, "EmotionEngine.SpatialIndex.FindNearestMatchesScan",
+    EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FEmotionSpatialIndexNearestTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NumRandomQueries = 20000;
+
+    // The lookup grid spans the VA plane for coordinates inside it, approximate lookups stay within one cell diagonal there
+    static constexpr double MaxApproximateError = UE_SQRT_2 * 2.0 / FEmotionSpatialIndex::NearestGridResolution + UE_KINDA_SMALL_NUMBER;
+
+    FRandomStream Random(0x454D4F);
+
+    // Layouts of emotion coordinates, with and without a lookup grid
+    TArray<TPair<FString, TArray<FVector2D>>> Layouts;
+    auto AddRandomLayout = [&Layouts, &Random](const TCHAR* Name, int32 NumEmotions)
+    {
+        TArray<FVector2D>& Coordinates = Layouts.Emplace_GetRef(Name, TArray<FVector2D>()).Value;
+        for (int32 Index = 0; Index < NumEmotions; ++Index)
+        {
+            Coordinates.Emplace(Random.FRandRange(-1.0f, 1.0f), Random.FRandRange(-1.0f, 1.0f));
+        }
+    };
+    AddRandomLayout(TEXT("Scanned"), FEmotionSpatialIndex::MinEmotionsForNearestGrid - 1);
+    AddRandomLayout(TEXT("Smallest grid"), FEmotionSpatialIndex::MinEmotionsForNearestGrid);
+    AddRandomLayout(TEXT("Large"), 500);
+
+    // Regular lattice, every border between two regions runs along cell edges and query points tie
+    {
+        TArray<FVector2D>& Coordinates = Layouts.Emplace_GetRef(TEXT("Lattice"), TArray<FVector2D>()).Value;
+        for (int32 Row = 0; Row < 8; ++Row)
+        {
+            for (int32 Column = 0; Column < 8; ++Column)
+            {
+                Coordinates.Emplace(-0.875 + Column * 0.25, -0.875 + Row * 0.25);
+            }
+        }
+    }
+
+    // Tight clusters with duplicated coordinates, ties must go to the lowest index like the scan
+    {
+        TArray<FVector2D>& Coordinates = Layouts.Emplace_GetRef(TEXT("Clusters"), TArray<FVector2D>()).Value;
+        for (int32 Cluster = 0; Cluster < 8; ++Cluster)
+        {
+            const FVector2D Center(Random.FRandRange(-0.9f, 0.9f), Random.FRandRange(-0.9f, 0.9f));
+            for (int32 Index = 0; Index < 6; ++Index)
+            {
+                Coordinates.Add(Center + FVector2D(Random.FRandRange(-0.01f, 0.01f), Random.FRandRange(-0.01f, 0.01f)));
+            }
+            Coordinates.Add(Center);
+            Coordinates.Add(Center);
+        }
+    }
+
+    for (const TPair<FString, TArray<FVector2D>>& Layout : Layouts)
+    {
+        const TArray<FVector2D>& Coordinates = Layout.Value;
+        FEmotionSpatialIndex SpatialIndex;
+        SpatialIndex.Build(Coordinates);
+        TestEqual(FString::Printf(TEXT("%s: lookup grid built"), *Layout.Key), SpatialIndex.HasNearestGrid(),
+            Coordinates.Num() >= FEmotionSpatialIndex::MinEmotionsForNearestGrid);
+
+        // Random points slightly beyond the VA plane, the emotions themselves and the midpoints between pairs of them
+        TArray<FVector2D> Queries;
+        for (int32 Index = 0; Index < NumRandomQueries; ++Index)
+        {
+            Queries.Emplace(Random.FRandRange(-1.2f, 1.2f), Random.FRandRange(-1.2f, 1.2f));
+        }
+        for (int32 Index = 0; Index < Coordinates.Num(); ++Index)
+        {
+            Queries.Add(Coordinates[Index]);
+            Queries.Add((Coordinates[Index] + Coordinates[(Index + 1) % Coordinates.Num()]) * 0.5);
+        }
+
+        int32 NumMismatches = 0;
+        double WorstApproximateError = 0.0;
+        for (const FVector2D& Query : Queries)
+        {
+            const int32 ScanIndex = SpatialIndex.FindNearestBruteForce(Query);
+            NumMismatches += SpatialIndex.FindNearest(Query) != ScanIndex;
+
+            if (FMath::Abs(Query.X) <= 1.0 && FMath::Abs(Query.Y) <= 1.0)
+            {
+                const int32 ApproximateIndex = SpatialIndex.FindNearestApproximate(Query);
+                const double Error = FVector2D::Distance(Query, Coordinates[ApproximateIndex]) - FVector2D::Distance(Query, Coordinates[ScanIndex]);
+                WorstApproximateError = FMath::Max(WorstApproximateError, Error);
+            }
+        }
+
+        AddInfo(FString::Printf(TEXT("%s: %d emotions, %d queries, approximate lookups at most %.4f farther"),
+            *Layout.Key, Coordinates.Num(), Queries.Num(), WorstApproximateError));
+        TestEqual(FString::Printf(TEXT("%s: FindNearest disagrees with the scan"), *Layout.Key), NumMismatches, 0);
+        TestTrue(FString::Printf(TEXT("%s: FindNearestApproximate stays within one cell diagonal"), *Layout.Key),
+            WorstApproximateError <= MaxApproximateError);
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
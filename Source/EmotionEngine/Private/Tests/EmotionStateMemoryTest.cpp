@@ -0,0 +1,66 @@
+#include "Misc/AutomationTest.h"
+#include "EmotionData.h"
+#include "EmotionStatePool.h"
+#include "EmotionTagSetTable.h"
+#include "EmotionTags.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEmotionStateMemoryBudgetTest, "EmotionEngine.StateData.MemoryBudget100k",
+    EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FEmotionStateMemoryBudgetTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NumAgents = 100000;
+
+    // Every agent carries as many emotions as fit inline, the common case the budget is sized for
+    const FGameplayTag EmotionTags[FEmotionStateData::NumInlineEmotions] = {
+        EmotionGameplayTags::Emotion_Core_Joy,
+        EmotionGameplayTags::Emotion_Core_Trust,
+        EmotionGameplayTags::Emotion_Core_Fear,
+        EmotionGameplayTags::Emotion_Core_Surprise
+    };
+
+    UEmotionLibrary* Library = NewObject<UEmotionLibrary>(GetTransientPackage());
+    for (const FGameplayTag& Tag : EmotionTags)
+    {
+        UEmotionDefinition* Definition = NewObject<UEmotionDefinition>(Library);
+        Definition->Emotion.Tag = Tag;
+        Library->Emotions.Add(Definition);
+    }
+    Library->BuildRuntimeData();
+
+    // The table is shared by every world, only the sets interned by this test count
+    const SIZE_T TagSetBytesBefore = FEmotionTagSetTable::Get().GetStats().InternedBytes;
+
+    FEmotionStateData Source;
+    Source.Initialize(Library);
+    for (const FGameplayTag& Tag : EmotionTags)
+    {
+        Source.AddEmotion(Tag, 50.0f, 0.0f);
+    }
+    TestTrue(TEXT("Source state carries its emotion tags"), Source.HasEmotionTag(EmotionTags[0]));
+
+    FEmotionStatePool StatePool;
+    TArray<FEmotionStateHandle> Handles;
+    StatePool.AllocateCopies(Source, 0.0f, NumAgents, Handles);
+    TestEqual(TEXT("Live pooled states"), StatePool.Num(), NumAgents);
+
+    // Slots, generations, free list and every state's own heap storage, which is non-zero once emotions spill out of
+    // the inline storage or pending combinations outgrow their inline bits
+    const SIZE_T PoolBytes = StatePool.GetAllocatedSize();
+    const SIZE_T TagSetBytesAfter = FEmotionTagSetTable::Get().GetStats().InternedBytes;
+    const SIZE_T TagSetBytes = TagSetBytesAfter > TagSetBytesBefore ? TagSetBytesAfter - TagSetBytesBefore : 0;
+
+    const SIZE_T TotalBytes = PoolBytes + TagSetBytes;
+    const SIZE_T BudgetBytes = NumAgents * FEmotionStateData::BytesPerAgentBudget;
+    AddInfo(FString::Printf(TEXT("%d agents: pool %.1f KB, tag sets %.1f KB, %.1f bytes per agent (budget %d)"),
+        NumAgents, PoolBytes / 1024.0, TagSetBytes / 1024.0, static_cast<double>(TotalBytes) / NumAgents, static_cast<int32>(FEmotionStateData::BytesPerAgentBudget)));
+    TestTrue(TEXT("Emotion state memory stays within BytesPerAgentBudget"), TotalBytes <= BudgetBytes);
+
+    StatePool.Reset();
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
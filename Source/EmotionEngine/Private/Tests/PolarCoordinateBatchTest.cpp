@@ -0,0 +1,107 @@
+#include "Misc/AutomationTest.h"
+#include "PolarCoordinate.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPolarCoordinateBatchBoundsTest, "EmotionEngine.PolarCoordinate.BatchErrorBounds",
+    EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPolarCoordinateBatchBoundsTest::RunTest(const FString& Parameters)
+{
+    // Tails of one to three values after zero, one and two full blocks of four, and a long run
+    static constexpr int32 Lengths[] = { 1, 2, 3, 4, 5, 6, 7, 9, 10, 11, 1003 };
+
+    // Angles compare around the circle, 359.9999 and 0 are neighbors
+    auto AngleError = [](float A, float B)
+    {
+        const float Difference = FMath::Abs(A - B);
+        return FMath::Min(Difference, 360.0f - Difference);
+    };
+
+    // Values picked by hand go first so even the shortest runs cover them
+    const float SpecialAngles[] = { 0.0f, 360.0f, -360.0f, -1.0e-7f, 359.99997f, 720.5f, -1.0e8f, 1.0e8f, 12345678.0f, -98765.4f };
+    const float SpecialIntensities[] = { -0.2f, 0.0f, 1.0f, -1.0e-6f, 1.1f, 0.5f, -0.05f, 0.999f, 0.25f, 1.0e-7f };
+    const FVector2D SpecialPoints[] = { FVector2D(0.0, 0.0), FVector2D(1.0, 0.0), FVector2D(0.0, -1.0), FVector2D(-1.1, 1.1), FVector2D(1.0e-9, -1.0e-9),
+        FVector2D(-1.0, 0.0), FVector2D(0.0, 1.0), FVector2D(-0.5, -0.5), FVector2D(1.0e-3, 1.0), FVector2D(1.1, -1.0e-4) };
+    static constexpr int32 NumSpecialValues = UE_ARRAY_COUNT(SpecialAngles);
+
+    FRandomStream Random(0x504F4C);
+    for (const int32 Num : Lengths)
+    {
+        TArray<float> Angles, Intensities, X, Y;
+        for (int32 Index = 0; Index < Num; ++Index)
+        {
+            if (Index < NumSpecialValues)
+            {
+                Angles.Add(SpecialAngles[Index]);
+                Intensities.Add(SpecialIntensities[Index]);
+                X.Add(static_cast<float>(SpecialPoints[Index].X));
+                Y.Add(static_cast<float>(SpecialPoints[Index].Y));
+                continue;
+            }
+
+            // A few turns or far from [0, 360), up to the 1e8 degrees NormalizeAngles is exact for
+            const float AngleMagnitude = Index % 2 == 0 ? Random.FRandRange(0.0f, 720.0f) : FMath::Pow(10.0f, Random.FRandRange(0.0f, 8.0f));
+            Angles.Add(Random.FRand() < 0.5f ? -AngleMagnitude : AngleMagnitude);
+            Intensities.Add(Random.FRandRange(-0.2f, 1.1f));
+            X.Add(Random.FRandRange(-1.1f, 1.1f));
+            Y.Add(Random.FRandRange(-1.1f, 1.1f));
+        }
+
+        TArray<float> NormalizedAngles, CartesianX, CartesianY, PolarAngles, PolarIntensities;
+        NormalizedAngles.SetNumUninitialized(Num);
+        CartesianX.SetNumUninitialized(Num);
+        CartesianY.SetNumUninitialized(Num);
+        PolarAngles.SetNumUninitialized(Num);
+        PolarIntensities.SetNumUninitialized(Num);
+        FPolarCoordinateBatch::NormalizeAngles(Angles, NormalizedAngles);
+        FPolarCoordinateBatch::PolarToCartesian(Angles, Intensities, CartesianX, CartesianY);
+        FPolarCoordinateBatch::CartesianToPolar(X, Y, PolarAngles, PolarIntensities);
+
+        float MaxNormalizeError = 0.0f;
+        float MaxCartesianError = 0.0f;
+        float MaxAngleError = 0.0f;
+        float MaxIntensityError = 0.0f;
+        for (int32 Index = 0; Index < Num; ++Index)
+        {
+            MaxNormalizeError = FMath::Max(MaxNormalizeError, AngleError(UPolarCoordinateLibrary::NormalizeAngle(Angles[Index]), NormalizedAngles[Index]));
+
+            // Negative intensities map to the origin, the scalar path clamps them the same way
+            const FVector2D Cartesian = UPolarCoordinateLibrary::PolarToCartesian(UPolarCoordinateLibrary::MakePolarCoordinate(Angles[Index], Intensities[Index]));
+            const float CartesianError = static_cast<float>(FMath::Max(FMath::Abs(Cartesian.X - CartesianX[Index]), FMath::Abs(Cartesian.Y - CartesianY[Index])));
+            MaxCartesianError = FMath::Max(MaxCartesianError, CartesianError / FMath::Max(Intensities[Index], 1.0f));
+
+            const FPolarCoordinate Polar = UPolarCoordinateLibrary::CartesianToPolar(FVector2D(X[Index], Y[Index]));
+            MaxAngleError = FMath::Max(MaxAngleError, AngleError(Polar.Angle, PolarAngles[Index]));
+            MaxIntensityError = FMath::Max(MaxIntensityError, FMath::Abs(Polar.Intensity - PolarIntensities[Index]) / FMath::Max(Polar.Intensity, UE_SMALL_NUMBER));
+        }
+
+        TestEqual(FString::Printf(TEXT("%d values: NormalizeAngles matches NormalizeAngle"), Num), MaxNormalizeError, 0.0f);
+        TestTrue(FString::Printf(TEXT("%d values: PolarToCartesian error %g within MaxCartesianError"), Num, MaxCartesianError),
+            MaxCartesianError <= FPolarCoordinateBatch::MaxCartesianError);
+        TestTrue(FString::Printf(TEXT("%d values: CartesianToPolar angle error %g within MaxAngleError"), Num, MaxAngleError),
+            MaxAngleError <= FPolarCoordinateBatch::MaxAngleError);
+        TestTrue(FString::Printf(TEXT("%d values: CartesianToPolar intensity error %g within MaxIntensityRelativeError"), Num, MaxIntensityError),
+            MaxIntensityError <= FPolarCoordinateBatch::MaxIntensityRelativeError);
+
+        // Outputs written over the inputs they replace give the same values as separate outputs
+        TArray<float> InPlaceAngles = Angles;
+        FPolarCoordinateBatch::NormalizeAngles(InPlaceAngles, InPlaceAngles);
+        TestTrue(FString::Printf(TEXT("%d values: NormalizeAngles in place"), Num), InPlaceAngles == NormalizedAngles);
+
+        TArray<float> AliasedX = Angles;
+        TArray<float> AliasedY = Intensities;
+        FPolarCoordinateBatch::PolarToCartesian(AliasedX, AliasedY, AliasedX, AliasedY);
+        TestTrue(FString::Printf(TEXT("%d values: PolarToCartesian over its inputs"), Num), AliasedX == CartesianX && AliasedY == CartesianY);
+
+        TArray<float> AliasedAngles = X;
+        TArray<float> AliasedIntensities = Y;
+        FPolarCoordinateBatch::CartesianToPolar(AliasedAngles, AliasedIntensities, AliasedAngles, AliasedIntensities);
+        TestTrue(FString::Printf(TEXT("%d values: CartesianToPolar over its inputs"), Num), AliasedAngles == PolarAngles && AliasedIntensities == PolarIntensities);
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -52,11 +52,29 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem")
     float Threshold = 0.0f;
 
-    // Array of Variatian Emotion that triggered by this emotion link. The Range check inside FEmotionTriggerRange uses the Link's Threshold value.
+    // Array of Variatian Emotion that triggered by this emotion link once the source emotion reaches Threshold. The Range check inside
+    // FEmotionTriggerRange uses the intensity of LinkEmotion, or the Link's Threshold value while LinkEmotion is not active.
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem")
     TArray<FEmotionTriggerRange> VariationEmotionTags;
 
-    // Gets the triggered variation tag based on the Link's Threshold value fitting within one of the VariationEmotionTags ranges.
+    // Gets the triggered variation tag while LinkEmotion is active: the first of the VariationEmotionTags ranges containing its intensity.
+    FORCEINLINE FGameplayTag GetEmotionTagTriggered(float LinkedIntensity) const
+    {
+        if (LinkedIntensity <= 0.0f)
+        {
+            return GetEmotionTagTriggered();
+        }
+        for (const FEmotionTriggerRange& TriggerRange : VariationEmotionTags)
+        {
+            if (TriggerRange.IsInRange(LinkedIntensity))
+            {
+                return TriggerRange.EmotionTagTriggered;
+            }
+        }
+        return FGameplayTag();
+    }
+
+    // Gets the triggered variation tag while LinkEmotion is not active, based on the Link's Threshold value fitting within one of the VariationEmotionTags ranges.
     FORCEINLINE FGameplayTag GetEmotionTagTriggered() const
     {
         for (const FEmotionTriggerRange& TriggerRange : VariationEmotionTags)
@@ -84,9 +102,9 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem")
     EEmotionType Type;
 
-    // Current intensity of this emotion (0.0 to 100.0)
-    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem", meta = (ClampMin = "0.0"))
-    float Intensity = 0.0f;
+    // Intensities belong to agents (FEmotionStateData), definitions are shared and never change at runtime
+    UPROPERTY(meta = (DeprecatedProperty, DeprecationMessage = "Read the agent's intensity from its emotion state or component instead"))
+    float Intensity_DEPRECATED = 0.0f;
 
     /* Valence Arousal Coordinate Express in Degrees angle and Intensity, convert to Vector 2D via util function
     * Vector 2D represent Valence as X Axis and Arousal as Y Axis
@@ -123,7 +141,8 @@ public:
     TArray<FEmotionLink> LinkEmotions;
 
 
-    FORCEINLINE FGameplayTagContainer GetAllEmotionTags() const
+    // Main tag plus the range and variation tags triggered at an agent's intensity of this emotion, with linked emotions not active
+    FORCEINLINE FGameplayTagContainer GetAllEmotionTags(float Intensity) const
     {
         FGameplayTagContainer AllTags;
         
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "GameplayTagContainer.h"
+#include "UObject/ObjectKey.h"
+#include "EmotionStateData.h"
+#include "EmotionArchetype.generated.h"
+
+class UEmotionLibrary;
+
+/**
+ * Shared starting point for every agent spawned from the same NPC archetype: initial emotions, VA coordinate,
+ * susceptibility and immunities. The baseline state is built once per archetype and library, for the library the
+ * caller resolved. Pooled components at a resting baseline read it directly and only get their own state when they
+ * diverge from it, see UEmotionComponent::Archetype. Only a baseline at rest is shared, one without InitialEmotions at
+ * a neutral InitialVACoordinate, since a decaying baseline would differ for agents spawned at different times. Agents
+ * of other archetypes start from their own copy of the baseline.
+ */
+UCLASS(BlueprintType)
+class EMOTIONENGINE_API UEmotionArchetype : public UDataAsset
+{
+    GENERATED_BODY()
+
+public:
+    UEmotionArchetype();
+
+    // Library the baseline is built with, components without their own library use it (default library if empty)
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
+    TObjectPtr<UEmotionLibrary> EmotionLibrary;
+
+    // Emotions active when an agent spawns (tag -> intensity 0-100)
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem", meta = (Categories = "Emotion"))
+    TMap<FGameplayTag, float> InitialEmotions;
+
+    // Valence-Arousal coordinate when an agent spawns
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
+    FVector2D InitialVACoordinate;
+
+    // Radius of influence in the VA space
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem", meta = (ClampMin = "0.0", UIMin = "0.0"))
+    float InfluenceRadius;
+
+    // Multiplier for incoming influences, replaces the component's value on initialization
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem", meta = (ClampMin = "0.0", UIMin = "0.0"))
+    float EmotionalSusceptibility;
+
+    // Spring stiffness for VA coordinate movement, replaces the component's value on initialization
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem", meta = (ClampMin = "0.0", UIMin = "0.0"))
+    float SpringStiffness;
+
+    // Damping factor for VA coordinate movement, replaces the component's value on initialization
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem", meta = (ClampMin = "0.0", UIMin = "0.0"))
+    float DampingFactor;
+
+    // Emotions every agent of the archetype is immune to, in addition to the component's own ImmuneEmotions
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem", meta = (Categories = "Emotion"))
+    FGameplayTagContainer ImmuneEmotions;
+
+    // Actors allowed to influence agents whose component has no AllowedInfluencers of its own (empty = all allowed)
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
+    TArray<TSubclassOf<AActor>> AllowedInfluencers;
+
+    // Actors blocked from influencing every agent of the archetype, in addition to the component's BlockedInfluencers
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
+    TArray<TSubclassOf<AActor>> BlockedInfluencers;
+
+    // Baseline state for agents using the library, built on first use, agents can share it while it IsAtRest. Null without
+    // a library: the archetype never resolves one itself, callers pass the one they resolved (EmotionLibrary or the world's default).
+    const FEmotionStateData* GetBaselineState(UEmotionLibrary* Library);
+
+    // Memory of the baseline states shared by the archetype's agents, zero until one is built
+    SIZE_T GetBaselineAllocatedSize() const;
+
+#if WITH_EDITOR
+    virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+    // Built on first use per library, heap allocated so agents at a baseline keep pointing at it
+    TMap<TObjectKey<UEmotionLibrary>, TUniquePtr<FEmotionStateData>> BaselineStates;
+
+    // Libraries referenced by the baseline states, kept alive here since the states are not traced
+    UPROPERTY(Transient)
+    TSet<TObjectPtr<UEmotionLibrary>> BaselineLibraries;
+
+    void BuildBaselineState(FEmotionStateData& BaselineState, UEmotionLibrary* Library) const;
+};
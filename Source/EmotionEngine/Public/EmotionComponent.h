@@ -8,7 +8,98 @@
 #include "Emotion.h"
 #include "EmotionComponent.generated.h"
 
+class UEmotionSubsystem;
+class UEmotionArchetype;
+
+/**
+ * How an FEmotionDelta is applied to a component
+ */
+UENUM(BlueprintType)
+enum class EEmotionDeltaOperation : uint8
+{
+	// Add the intensity to the current intensity (AddEmotion)
+	Add,
+
+	// Replace the current intensity (SetEmotionIntensity)
+	Set,
+
+	// Remove the emotion, the intensity is ignored (RemoveEmotion)
+	Remove
+};
+
+/**
+ * A single emotion change applied as part of a batch
+ */
+USTRUCT(BlueprintType)
+struct EMOTIONENGINE_API FEmotionDelta
+{
+	GENERATED_BODY()
+
+	// The emotion to change
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem", meta = (Categories = "Emotion"))
+	FGameplayTag EmotionTag;
+
+	// Intensity to add or set (0-100)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem")
+	float Intensity = 0.0f;
+
+	// How the intensity is applied
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem")
+	EEmotionDeltaOperation Operation = EEmotionDeltaOperation::Add;
+};
+
+/**
+ * Net change of one emotion, reported in coalesced change sets
+ */
+USTRUCT(BlueprintType)
+struct EMOTIONENGINE_API FEmotionChange
+{
+	GENERATED_BODY()
+
+	// The emotion that changed
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
+	FGameplayTag EmotionTag;
+
+	// Intensity before the change (0 if the emotion was not active)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
+	float PreviousIntensity = 0.0f;
+
+	// Intensity after the change (0 if the emotion was removed)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
+	float NewIntensity = 0.0f;
+
+	FEmotionChange() {}
+
+	FEmotionChange(const FGameplayTag& InEmotionTag, float InPreviousIntensity, float InNewIntensity)
+		: EmotionTag(InEmotionTag), PreviousIntensity(InPreviousIntensity), NewIntensity(InNewIntensity) {}
+};
+
+/**
+ * Emotion change received while a component's library is still streaming in, 12 bytes. Changes are replayed in the
+ * order they arrived once the library is loaded, a change is merged into the previous one for the same emotion only
+ * when that gives the same result.
+ */
+struct EMOTIONENGINE_API FEmotionPendingStimulus
+{
+	// Changes a component buffers at most, later ones are dropped
+	static constexpr int32 MaxPendingStimuli = 64;
+
+	// Steps of the fixed-point intensity per intensity point
+	static constexpr float IntensityScale = 100.0f;
+
+	FGameplayTag EmotionTag;
+
+	// Signed fixed-point intensity, additive influences can lower an emotion
+	int16 QuantizedIntensity = 0;
+
+	EEmotionDeltaOperation Operation = EEmotionDeltaOperation::Add;
+
+	float GetIntensity() const { return QuantizedIntensity / IntensityScale; }
+	void SetIntensity(float InIntensity) { QuantizedIntensity = static_cast<int16>(FMath::Clamp(FMath::RoundToInt32(InIntensity * IntensityScale), -10000, 10000)); }
+};
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnEmotionChanged, const FGameplayTag&, EmotionTag, float, Intensity);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnEmotionsChanged, const TArray<FEmotionChange>&, Changes);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnEmotionalInfluence, AActor*, Influencer, const FGameplayTag&, EmotionTag, float, Intensity);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnVACoordinateChanged, const FVector2D&, NewVACoordinate);
 
@@ -33,6 +124,18 @@ public:
 	// Called when the component is destroyed
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
+	// Release the pooled state if EndPlay did not
+	virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override;
+
+	// Call when the owning actor is parked in an actor pool instead of destroyed. Unregisters the component, returns its
+	// pooled state slot and clears a standalone state in place, keeping the UEmotionState and its storage for reuse.
+	UFUNCTION(BlueprintCallable, Category = "EmotionSystem|Pooling")
+	void ReleaseForActorPool();
+
+	// Call when a pooled actor is taken out of its pool, restarts the emotion state from the archetype and re-registers
+	UFUNCTION(BlueprintCallable, Category = "EmotionSystem|Pooling")
+	void ReuseFromActorPool();
+
 	// Add an emotion with intensity (0-100)
 	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
 	void AddEmotion(const FGameplayTag& EmotionTag, float Intensity);
@@ -45,6 +148,17 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
 	void SetEmotionIntensity(const FGameplayTag& EmotionTag, float Intensity);
 
+	// Start a batch of emotion changes, derived state is rebuilt and listeners are notified once on CommitEmotionBatch.
+	// C++ only, every Begin must be paired with a Commit: a batch left open freezes the emotion tags and the decay time.
+	void BeginEmotionBatch();
+
+	// Apply the batch started with BeginEmotionBatch and broadcast its net changes as one change set
+	void CommitEmotionBatch();
+
+	// Apply several emotion changes as a single batch, the Blueprint way to batch since it always commits
+	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
+	void ApplyEmotionDeltas(const TArray<FEmotionDelta>& Deltas);
+
 	// Get intensity for any emotion tag
 	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
 	float GetEmotionIntensity(const FGameplayTag& EmotionTag) const;
@@ -53,10 +167,25 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
 	bool HasEmotionTag(const FGameplayTag& EmotionTag) const;
 
+	// Check if the component has any of the given emotion tags
+	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
+	bool HasAnyEmotionTags(const FGameplayTagContainer& EmotionTags) const;
+
+	// Check if the component has all of the given emotion tags
+	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
+	bool HasAllEmotionTags(const FGameplayTagContainer& EmotionTags) const;
+
+	// Match a query compiled once for many components (see UEmotionSubsystem)
+	bool MatchesAnyEmotionTags(const FEmotionTagQueryMask& Query) const;
+	bool MatchesAllEmotionTags(const FEmotionTagQueryMask& Query) const;
+
 	// Get all emotion tags (active, range, and combined)
 	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
 	FGameplayTagContainer GetAllEmotionTags() const;
 
+	// Id of the interned emotion tag set, components with equal ids carry equal tags (see FEmotionTagSetTable)
+	uint32 GetEmotionTagSetId() const;
+
 	// Get all active emotions
 	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
 	TArray<FActiveEmotion> GetActiveEmotions() const;
@@ -89,6 +218,10 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "EmotionSystem")
 	FOnEmotionChanged OnEmotionChanged;
 
+	// Event triggered at most once per frame (or once per committed batch when notifications are not deferred) with every changed emotion
+	UPROPERTY(BlueprintAssignable, Category = "EmotionSystem")
+	FOnEmotionsChanged OnEmotionsChanged;
+
 	// Event triggered when the VA coordinate changes
 	UPROPERTY(BlueprintAssignable, Category = "EmotionSystem")
 	FOnVACoordinateChanged OnVACoordinateChanged;
@@ -117,14 +250,87 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
 	void SetEmotionalSusceptibility(float NewSusceptibility);
 
+	// Check if this component is immune to the given emotion
+	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
+	bool IsImmuneToEmotion(const FGameplayTag& EmotionTag) const;
+
+	// Set the emotions this component is immune to
+	UFUNCTION(BlueprintSetter, Category = "EmotionSystem")
+	void SetImmuneEmotions(const FGameplayTagContainer& NewImmuneEmotions);
+
+	// Get a Blueprint view of the emotion state, created on demand for pooled states
+	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
+	UEmotionState* GetEmotionState();
+
+	// True if the emotion state lives in the subsystem's state pool
+	bool IsUsingPooledState() const { return PooledStateHandle.IsValid(); }
+
+	// Set the archetype the component starts from, only takes effect before the emotion state is initialized
+	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
+	void SetArchetype(UEmotionArchetype* NewArchetype);
+
+	UEmotionArchetype* GetArchetype() const { return Archetype; }
+
+	// Configuration UEmotionSubsystem::InitializeEmotionComponents groups components by
+	bool HasOwnEmotionLibrary() const { return EmotionLibrary || !StreamedEmotionLibrary.IsNull(); }
+	bool WantsPooledState() const { return bUsePooledState; }
+
+	// True once the component has an emotion state of its own, a pooled one or its archetype's shared baseline
+	bool IsEmotionStateInitialized() const;
+
+	// True while the library is streaming in, emotion changes are buffered and replayed once it is loaded
+	bool IsWaitingForEmotionLibrary() const { return LibraryLoadHandle.IsValid() && LibraryLoadHandle->IsLoadingInProgress(); }
+
+	// Take over a pooled state the subsystem already allocated and filled for this component
+	void AdoptPooledState(UEmotionSubsystem* EmotionSubsystem, const FEmotionStateHandle& Handle);
+
+	// Initialize the emotion state if not already done, UEmotionSubsystem::InitializeEmotionComponents calls it for components it does not pool
+	void InitializeEmotionState();
+
+	// True if the component has no state of its own and reads its archetype's shared baseline
+	bool IsAtArchetypeBaseline() const { return ArchetypeBaseline != nullptr; }
+
+	// The emotion state, null until it has been initialized. The mutable accessor gives an agent at its archetype
+	// baseline a state of its own, use the const one for reading.
+	FEmotionStateData* GetStateData();
+	const FEmotionStateData* GetStateData() const;
+
+	// Drop the component's own pooled state if it has returned to its archetype's resting baseline, called by the subsystem after each update
+	bool TryCollapseToArchetypeBaseline();
+
+	// Push the component's spring settings into the emotion state, called by the subsystem before ticking pooled states
+	void SyncStateSettings();
+
+	// Compare the state against what listeners last saw and dispatch one coalesced notification
+	void DispatchChangeNotifications();
+
 	// Get the owner's display name for debugging
 	FString GetOwnerName() const;
 
+	/**
+	 * Memory used by this agent, for the subsystem's memory report
+	 * @param OutOwnedBytes - UEmotionState object and the heap of a state it owns
+	 * @param OutPooledBytes - Slot of a pooled state, also counted by the subsystem's pool
+	 * @param OutQueueBytes - Batch and change notification bookkeeping
+	 */
+	void GetEmotionMemoryUsage(SIZE_T& OutOwnedBytes, SIZE_T& OutPooledBytes, SIZE_T& OutQueueBytes) const;
+
 protected:
-	// The emotion library to use (if not specified, will use default from game instance)
+	// The emotion library to use (if not specified, will use StreamedEmotionLibrary, the archetype's library or the world's default library)
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
 	TObjectPtr<UEmotionLibrary> EmotionLibrary;
 
+	// Library streamed in when the component starts, used when EmotionLibrary is not set. Emotion changes received
+	// before it is loaded are buffered and replayed, so levels never stall on loading it.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
+	TSoftObjectPtr<UEmotionLibrary> StreamedEmotionLibrary;
+
+	// Shared starting state and settings. Its susceptibility and spring settings replace the component's on initialization,
+	// its immunities and blocked influencers add to the component's. Pooled agents share the archetype's baseline until they diverge
+	// when it is at rest, i.e. the archetype has no initial emotions and a neutral initial VA coordinate.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
+	TObjectPtr<UEmotionArchetype> Archetype;
+
 	// How susceptible this actor is to emotional influences (multiplier for incoming influences)
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem", meta = (ClampMin = "0.0", UIMin = "0.0"))
 	float EmotionalSusceptibility;
@@ -133,12 +339,29 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem", meta = (ClampMin = "0.0", UIMin = "0.0"))
 	float SpringStiffness;
 
-	// Damping factor for VA coordinate movement (higher = less oscillation)
+	// Damping factor for VA coordinate movement (higher = less oscillation, 2 * sqrt(SpringStiffness) is critical damping)
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem", meta = (ClampMin = "0.0", UIMin = "0.0"))
 	float DampingFactor;
 
+	// Keep the emotion state in the subsystem's state pool instead of a UEmotionState object. Pooled states are ticked
+	// in one batch by the subsystem and add no UObject per actor, GetEmotionState creates a Blueprint view on demand.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
+	bool bUsePooledState;
+
+	// Collect emotion changes and report them once per frame after the emotion state update, instead of on every change
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem|Notifications")
+	bool bDeferChangeNotifications;
+
+	// Minimum intensity drift since the last reported value before a change is reported again (entering and leaving are always reported)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem|Notifications", meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float IntensityChangeThreshold;
+
+	// Minimum VA coordinate drift per axis since the last reported value before OnVACoordinateChanged fires again
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem|Notifications", meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float VAChangeThreshold;
+
 	// Tags for emotions this actor is immune to (will not be affected by these)
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem", meta = (Categories = "Emotion"))
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, BlueprintSetter = SetImmuneEmotions, Category = "EmotionSystem", meta = (Categories = "Emotion"))
 	FGameplayTagContainer ImmuneEmotions;
 
 	// Actors that are allowed to influence this component's emotions (empty = all allowed)
@@ -149,8 +372,8 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem")
 	TArray<TSubclassOf<AActor>> BlockedInfluencers;
 
-	// Notify listeners that an emotion has changed
-	void BroadcastEmotionChanged(const FGameplayTag& EmotionTag, float Intensity);
+	// Notify listeners of a committed change set
+	void BroadcastEmotionsChanged(const TArray<FEmotionChange>& Changes);
 
 	// Notify listeners that the VA coordinate has changed
 	void BroadcastVACoordinateChanged(const FVector2D& NewVACoordinate);
@@ -159,10 +382,73 @@ protected:
 	void BroadcastEmotionalInfluence(AActor* Influencer, const FGameplayTag& EmotionTag, float Intensity);
 
 private:
-	// The emotional state managed by this component
+	// The emotional state managed by this component, or the Blueprint view of its pooled state
 	UPROPERTY()
 	TObjectPtr<UEmotionState> EmotionState;
 
-	// Initialize the emotion state if not already done
-	void InitializeEmotionState();
+	// State in the subsystem's pool when bUsePooledState is set
+	FEmotionStateHandle PooledStateHandle;
+
+	// Subsystem owning the pooled state
+	TWeakObjectPtr<UEmotionSubsystem> StatePoolOwner;
+
+	// World time used to stamp emotion changes
+	float GetStateTime() const;
+
+	// Return the pooled state to the subsystem
+	void ReleasePooledState();
+
+	// Archetype baseline read while the component has no state of its own, owned by Archetype
+	const FEmotionStateData* ArchetypeBaseline = nullptr;
+
+	// Give a component at its archetype baseline its own pooled copy of the baseline
+	void MaterializeArchetypeState();
+
+	// Copy the archetype's susceptibility and spring settings into the component
+	void ApplyArchetypeSettings();
+
+	// ImmuneEmotions compiled into the emotion library's tag space
+	FEmotionTagMask ImmuneEmotionMask;
+
+	// Nesting depth of BeginEmotionBatch calls
+	int32 BatchDepth = 0;
+
+	// Intensity of every emotion touched by the current batch, captured before its first change
+	TMap<FGameplayTag, float> BatchBaseline;
+
+	// Remember the intensity of an emotion before the current batch changes it
+	void RecordBatchBaseline(const FGameplayTag& EmotionTag);
+
+	// Intensities last reported to listeners, compared against the state after each update
+	TMap<FGameplayTag, float> LastNotifiedIntensities;
+
+	// VA coordinate last reported to listeners
+	FVector2D LastNotifiedVA = FVector2D::ZeroVector;
+
+	// Record reported changes as the new notification baseline
+	void UpdateNotifiedIntensities(const TArray<FEmotionChange>& Changes);
+
+	// Load of the library the emotion state waits for, held for the component's lifetime to keep the library loaded
+	TSharedPtr<FStreamableHandle> LibraryLoadHandle;
+
+	// Emotion changes received while waiting for the library, in the order they arrived
+	TArray<FEmotionPendingStimulus> PendingStimuli;
+
+	// VA coordinate set while waiting for the library
+	TOptional<FVector2D> PendingVACoordinate;
+
+	// Start loading the library if that has not been done yet, returns it once it is in memory
+	UEmotionLibrary* RequestEmotionLibraryLoad(const FSoftObjectPath& LibraryPath);
+
+	// Initialize the emotion state with the loaded library and replay the buffered changes
+	void OnEmotionLibraryLoaded();
+
+	// Buffer an emotion change if the library is still loading, false if the change can be applied now
+	bool BufferWhileLibraryLoads(EEmotionDeltaOperation Operation, const FGameplayTag& EmotionTag, float Intensity);
+
+	// Apply the changes buffered while the library was loading, as one batch
+	void ReplayPendingStimuli();
+
+	// Rebuild ImmuneEmotionMask after the immunities or the library changed
+	void UpdateImmuneEmotionMask();
 };
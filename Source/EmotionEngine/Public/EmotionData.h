@@ -4,13 +4,19 @@
 #include "Engine/DataAsset.h"
 #include "GameplayTagContainer.h"
 #include "Emotion.h"
+#include "EmotionTagMask.h"
+#include "EmotionSpatialIndex.h"
+#include "EmotionZone.h"
 #include "Interfaces/Interface_AssetUserData.h"
 #include "UObject/Object.h"
 #include "EditorFramework/AssetImportData.h"
+#include "Engine/StreamableManager.h"
 #include "EmotionData.generated.h"
 
 class UEmotionDefinition;
 class UEmotionLibrary;
+class UCombinedEmotionMapping;
+class UTexture2D;
 
 /**
  * Struct for mapping emotion combinations to result emotions
@@ -29,6 +35,143 @@ public:
     TObjectPtr<UEmotionDefinition> ResultEmotion;
 };
 
+/**
+ * Runtime form of a FCombineEmotionMapping, compiled by UEmotionLibrary
+ */
+struct EMOTIONENGINE_API FEmotionCompiledCombination
+{
+    // Exact bits of the trigger tags in the library's tag space
+    FEmotionTagMask TriggerMask;
+
+    // Trigger tags, used to look up the intensities that feed the result
+    TArray<FGameplayTag> TriggerTags;
+
+    // Index of the result emotion in the library's runtime emotions
+    int32 ResultEmotionIndex = INDEX_NONE;
+
+    FGameplayTag ResultTag;
+};
+
+/**
+ * Set of emotion tags as a hash key: valid tags only, sorted and without duplicates, so the order tags are given in does not matter
+ */
+struct EMOTIONENGINE_API FEmotionTriggerSetKey
+{
+    TArray<FGameplayTag, TInlineAllocator<4>> Tags;
+
+    FEmotionTriggerSetKey() {}
+
+    explicit FEmotionTriggerSetKey(TConstArrayView<FGameplayTag> InTags);
+
+    FORCEINLINE bool operator==(const FEmotionTriggerSetKey& Other) const { return Tags == Other.Tags; }
+
+    friend FORCEINLINE uint32 GetTypeHash(const FEmotionTriggerSetKey& Key)
+    {
+        uint32 Hash = 0;
+        for (const FGameplayTag& Tag : Key.Tags)
+        {
+            Hash = HashCombineFast(Hash, GetTypeHash(Tag));
+        }
+        return Hash;
+    }
+};
+
+/**
+ * All combinations of a library flattened into one array, indexed by the emotions that participate in them
+ */
+struct EMOTIONENGINE_API FEmotionCombinationTable
+{
+    TArray<FEmotionCompiledCombination> Combinations;
+
+    // Active emotion tag -> indices of the combinations that must be re-evaluated when that emotion changes
+    TMap<FGameplayTag, TArray<int32>> AffectedCombinations;
+
+    // Trigger set -> first combination with exactly those triggers, pairs and larger sets alike
+    TMap<FEmotionTriggerSetKey, int32> CombinationsByTriggers;
+
+    // Set when a trigger names a parent of an emotion of the library, lookups missing the exact set then also try the
+    // parents of the given tags like FGameplayTagContainer::HasAll did
+    bool bHasParentTriggers = false;
+
+    // RuntimeEmotions must contain every result emotion of the mappings
+    void Build(const TArray<TObjectPtr<UCombinedEmotionMapping>>& Mappings, TConstArrayView<UEmotionDefinition*> RuntimeEmotions, const FEmotionTagSpace& TagSpace);
+
+    void Reset();
+
+    // Heap memory used by the table
+    SIZE_T GetAllocatedSize() const;
+
+    FORCEINLINE int32 Num() const { return Combinations.Num(); }
+
+    FORCEINLINE const TArray<int32>* FindAffectedCombinations(const FGameplayTag& EmotionTag) const
+    {
+        return AffectedCombinations.Find(EmotionTag);
+    }
+
+    // Combination triggered by exactly these emotions in any order, INDEX_NONE if there is none. One hash probe unless
+    // the library has parent tag triggers and the exact set has no combination.
+    int32 FindCombination(TConstArrayView<FGameplayTag> EmotionTags) const;
+};
+
+/**
+ * Intensity bracket of a compiled emotion: the interval up to the next bracket's start over which no tag derived from
+ * the emotion's intensity changes. Brackets split 0-100 where an intensity enters or leaves a range, reaches a link
+ * threshold, or enters or leaves a variation range of a link pointing at the emotion.
+ */
+struct EMOTIONENGINE_API FEmotionCompiledBracket
+{
+    // Lowest intensity of the bracket, excluded if the bracket starts where a range ends
+    float Start = 0.0f;
+    bool bExclusiveStart = false;
+
+    // Main tag plus the range tags triggered anywhere in the bracket, link variations are read from the link grids
+    FGameplayTagContainer Tags;
+
+    FORCEINLINE bool IsReachedBy(float Intensity) const
+    {
+        return bExclusiveStart ? Intensity > Start : Intensity >= Start;
+    }
+};
+
+/**
+ * Link of a compiled emotion as a grid of variations indexed by intensity brackets: one row per bracket of the source
+ * emotion, one column for an inactive linked emotion followed by one per bracket of the linked emotion
+ */
+struct EMOTIONENGINE_API FEmotionCompiledLink
+{
+    // Index of the linked emotion in the library's runtime emotions, INDEX_NONE if the library does not have it
+    int32 LinkedIndex = INDEX_NONE;
+
+    // Slice of the library's link cells, rows * NumColumns. A cell is 0 for no variation, else 1 + the variation's index.
+    int32 FirstCell = 0;
+    int32 NumColumns = 1;
+
+    // Slice of the library's link variation tags
+    int32 FirstVariation = 0;
+};
+
+/**
+ * Runtime data of one emotion of a library, compiled from its definition so emotion states never read the asset
+ */
+struct EMOTIONENGINE_API FEmotionCompiledEmotion
+{
+    // Cartesian VA coordinate, converted from the polar coordinate once
+    FVector2D Coordinate = FVector2D::ZeroVector;
+
+    float DecayRate = 0.0f;
+
+    // Index of the opposite emotion in the library's runtime emotions
+    int32 OppositeIndex = INDEX_NONE;
+
+    // Slice of the library's flattened bracket table, sorted by intensity, at least one bracket
+    int32 FirstBracket = 0;
+    int32 NumBrackets = 0;
+
+    // Slice of the library's flattened link table
+    int32 FirstLink = 0;
+    int32 NumLinks = 0;
+};
+
 /** 
  * Emotion Tendency is mapping of coefficients to input emotions intensity
  * This is used mainly to express how personality affects certain emotions more than others
@@ -62,10 +205,15 @@ public:
     // Array of emotion combinations and their results
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem", meta = (Categories = "Emotion"))
     TArray<FCombineEmotionMapping> CombinedEmotions;
+
+#if WITH_EDITOR
+    virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
 };
 
 /**
- * Data asset containing information about a single emotion
+ * Data asset containing information about a single emotion. Definitions are authored data shared by every agent
+ * and immutable after load, so they can be read from any thread. Intensities live in each agent's FEmotionStateData.
  */
 UCLASS(BlueprintType)
 class EMOTIONENGINE_API UEmotionDefinition : public UDataAsset
@@ -87,14 +235,19 @@ public:
 #if WITH_EDITOR
     // ~ Override UObject Interface
     virtual void PostInitProperties() override;
+    virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
     // ~ End Override UObject Interface
+
+    // Log the presentation data stripped from server cooks since the last report, once per platform
+    static void ReportStrippedPresentationData();
 #endif
+    virtual void Serialize(FArchive& Ar) override;
 
-    // Display name for this emotion
+    // Display name for this emotion, empty on servers cooked with UEmotionEngineSettings::bStripPresentationDataForServer
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
     FText DisplayName;
     
-    // Description of this emotion
+    // Description of this emotion, empty on servers cooked with UEmotionEngineSettings::bStripPresentationDataForServer
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem", meta = (MultiLine = true))
     FText Description;
     
@@ -102,25 +255,33 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
     FLinearColor Color;
     
-    // Optional icon for this emotion
+    // Optional icon for this emotion, not loaded with the definition. UI loads it on demand (RequestIconLoad, or Async Load Asset in Blueprint)
+    // or with its library's UEmotionLibrary::IconBundle.
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
-    TObjectPtr<UTexture2D> Icon;
+    TSoftObjectPtr<UTexture2D> Icon;
+    
+    // The icon if it is already loaded, null otherwise
+    UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
+    UTexture2D* GetLoadedIcon() const;
+    
+    // Start loading the icon, OnLoaded runs once it is in memory. Keep the handle to keep the icon loaded.
+    TSharedPtr<FStreamableHandle> RequestIconLoad(FStreamableDelegate OnLoaded = FStreamableDelegate()) const;
     
-    // Get all emotion tags associated with this emotion (main tag + triggered range and variation tags)
+    // Get all emotion tags associated with this emotion at an intensity (main tag + triggered range and variation tags)
     UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
-    FGameplayTagContainer GetAllEmotionTags() const;
+    FGameplayTagContainer GetAllEmotionTags(float Intensity) const;
     
-    // Update emotion intensity and return any newly triggered emotion tags
+    // Get the emotion tags triggered by an intensity change that were not active before it
     UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
-    FGameplayTagContainer UpdateIntensity(float DeltaIntensity);
+    FGameplayTagContainer GetNewlyTriggeredTags(float PreviousIntensity, float NewIntensity) const;
     
     // Get Emotion Coordinate
     UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
     FVector2D GetEmotionCoordinate() const;
     
-    // Apply decay to emotion intensity based on time passed
+    // Get an intensity after decaying for the time passed
     UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
-    void ApplyDecay(float DeltaTime);
+    float GetDecayedIntensity(float Intensity, float DeltaTime) const;
     
     // Check if this emotion is opposite to the given emotion tag
     UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
@@ -128,14 +289,19 @@ public:
 };
 
 /**
- * Data asset containing a collection of emotions and their relationships
+ * Data asset containing a collection of emotions and their relationships. Libraries are primary assets of type
+ * EmotionLibrary: add the type to the Asset Manager settings to stream them in by id, with the icons of their
+ * emotions in the IconBundle bundle.
  */
 UCLASS(BlueprintType)
-class EMOTIONENGINE_API UEmotionLibrary : public UDataAsset
+class EMOTIONENGINE_API UEmotionLibrary : public UPrimaryDataAsset
 {
     GENERATED_BODY()
 
 public:
+    // Asset bundle listing the icons of the library's emotions
+    static const FName IconBundle;
+
     // All emotions in this library
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "EmotionSystem")
     TArray<TObjectPtr<class UEmotionDefinition>> Emotions;
@@ -160,7 +326,7 @@ public:
     UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
     TArray<UEmotionDefinition*> GetOppositeEmotions(const FGameplayTag& EmotionTag) const;
     
-    // Get all emotions that are adjacent to the given emotion (closest in VACoordinate)
+    // Get all emotions that are adjacent to the given emotion (closest in VACoordinate first), precomputed up to FEmotionSpatialIndex::AdjacencyRadius
     UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
     TArray<UEmotionDefinition*> GetAdjacentEmotions(const FGameplayTag& EmotionTag, float MaxDistance = 0.3f) const;
     
@@ -168,7 +334,156 @@ public:
     UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
     UEmotionDefinition* GetCombinedEmotion(const FGameplayTag& EmotionTag1, const FGameplayTag& EmotionTag2) const;
     
-    // Find emotions within a certain radius in the VA space
+    // Get the result of combining a set of emotions, all of a mapping's triggers and nothing else
+    UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
+    UEmotionDefinition* GetCombinedEmotionForTags(const FGameplayTagContainer& EmotionTags) const;
+    
+    // Get the result of combining a set of emotions given in any order
+    UEmotionDefinition* GetCombinedEmotionForTags(TConstArrayView<FGameplayTag> EmotionTags) const;
+    
+    // Find emotions within a certain radius in the VA space, closest first
     UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
     TArray<UEmotionDefinition*> FindEmotionsInRadius(const FVector2D& VACoordinate, float Radius) const;
+
+    // Largest number of runtime emotions, active emotions store their index in 16 bits
+    static constexpr int32 MaxRuntimeEmotions = MAX_uint16;
+
+    // Every emotion that can be active in a state using this library: the authored emotions followed by combination results,
+    // one per tag (the first one wins). Indices are stable until the library is recompiled, the library holds the only strong references.
+    TConstArrayView<UEmotionDefinition*> GetRuntimeEmotions() const;
+
+    // Tags of the runtime emotions, same order as GetRuntimeEmotions
+    TConstArrayView<FGameplayTag> GetRuntimeEmotionTags() const;
+
+    // Index of the runtime emotion for a tag, INDEX_NONE if the library has no emotion with that tag
+    int32 FindEmotionIndex(const FGameplayTag& EmotionTag) const;
+
+    // Compiled data of the runtime emotions, same order as GetRuntimeEmotions
+    TConstArrayView<FEmotionCompiledEmotion> GetCompiledEmotions() const;
+
+    // Cartesian VA coordinate of an emotion, false if the library has no emotion with that tag
+    bool GetEmotionCoordinate(const FGameplayTag& EmotionTag, FVector2D& OutCoordinate) const;
+
+    // Authored emotion closest to a VA coordinate, null if the library is empty. Read from the compiled lookup grid,
+    // exact by default, bApproximate returns the closest emotion of the grid cell in constant time (see FEmotionSpatialIndex)
+    UEmotionDefinition* FindClosestEmotion(const FVector2D& VACoordinate, bool bApproximate = false) const;
+
+    // Zones of the core emotion wheel containing a VA coordinate: the core emotion's cone, its range at the coordinate's
+    // radius and the variation the coordinate leans toward. Read from the zone table compiled with the library.
+    UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
+    FEmotionZonePath GetEmotionZonePath(const FVector2D& VACoordinate) const;
+
+    // Zone paths of many VA coordinates at once, large batches are classified in parallel. OutPaths must be as large as VACoordinates.
+    void GetEmotionZonePaths(TConstArrayView<FVector2D> VACoordinates, TArrayView<FEmotionZonePath> OutPaths) const;
+
+    // Add the tags of a set of active emotions, given as runtime emotion indices and intensities above zero: their own tags,
+    // the ranges containing their intensity and the variations of the links whose threshold they reach, chosen by the
+    // intensity of the linked emotion. One bracket lookup per emotion and one grid cell per link.
+    void AppendTriggeredTags(TConstArrayView<int32> EmotionIndices, TConstArrayView<float> Intensities, FGameplayTagContainer& OutTags) const;
+
+    // Add the tags a runtime emotion carries at an intensity on its own, its links see their linked emotions as inactive
+    void AppendTriggeredTags(int32 EmotionIndex, float Intensity, FGameplayTagContainer& OutTags) const;
+
+    // Bracket of a runtime emotion containing an intensity. The tags derived from the emotion's intensity, its links to
+    // and from other emotions included, only change when its bracket does, so comparing brackets tells whether an
+    // intensity change affects an agent's tags
+    int32 FindIntensityBracket(int32 EmotionIndex, float Intensity) const;
+
+    // Tags a runtime emotion carries in one of its brackets
+    const FGameplayTagContainer& GetBracketTags(int32 EmotionIndex, int32 Bracket) const;
+
+    // Runtime emotion at an index, null if the index is out of range
+    UEmotionDefinition* GetEmotionByIndex(int32 EmotionIndex) const;
+
+    // Grid and neighbor graph over the coordinates of the authored emotions, indices match GetRuntimeEmotions
+    const FEmotionSpatialIndex& GetSpatialIndex() const;
+
+    // Zone hierarchy of the core emotions compiled into an angle and radius lookup table
+    const FEmotionZoneTable& GetZoneTable() const;
+
+    // Compiled tag bit space covering every tag referenced by this library and all of their parents
+    const FEmotionTagSpace& GetTagSpace() const;
+
+    // Id of the current compilation of the runtime data, unique across libraries and changed by every BuildRuntimeData
+    uint32 GetCompileId() const;
+
+    // Compiled combination mappings of this library
+    const FEmotionCombinationTable& GetCombinationTable() const;
+
+    // Rebuild the compiled runtime data from the authored emotions and combinations
+    void BuildRuntimeData();
+
+    // Mark the compiled runtime data of every library as stale, called whenever emotion assets are edited
+    static void NotifyEmotionDataChanged();
+
+    // Memory of the library object, its authored arrays and its compiled runtime data, emotion assets excluded
+    SIZE_T GetLibraryAllocatedSize() const;
+
+    // ~ Override UObject Interface
+    virtual void PostLoad() override;
+    virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+#if WITH_EDITOR
+    virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+    // ~ End Override UObject Interface
+
+#if WITH_EDITORONLY_DATA
+    // ~ Override UPrimaryDataAsset Interface
+    virtual void UpdateAssetBundleData() override;
+    // ~ End Override UPrimaryDataAsset Interface
+#endif
+
+private:
+    // Rebuild the runtime data if the authored data changed since it was last compiled
+    void EnsureRuntimeData() const;
+
+    // Every tag referenced by the emotions and combinations of this library
+    void GatherReferencedTags(TArray<FGameplayTag>& OutTags) const;
+
+    // Build the runtime emotion list and its tag index
+    void BuildRuntimeEmotions();
+
+    // Compile the coordinates, decay rates, opposites and intensity brackets of the runtime emotions
+    void BuildCompiledEmotions();
+
+    // Compile the zone hierarchy: core emotion cones meet halfway between neighboring core emotions, ranges are radius
+    // bands of their cone and variations split the cone toward the emotions their links point at
+    void BuildZoneTable();
+
+    // Raw pointers are kept alive by Emotions and CombineEmotions
+    mutable TArray<UEmotionDefinition*> RuntimeEmotions;
+
+    // Emotion tag of each entry in RuntimeEmotions
+    mutable TArray<FGameplayTag> RuntimeEmotionTags;
+
+    // Tag -> index in RuntimeEmotions
+    mutable TMap<FGameplayTag, int32> RuntimeEmotionIndices;
+
+    // Authored emotions come first in RuntimeEmotions, combination results follow
+    mutable int32 NumAuthoredRuntimeEmotions = 0;
+
+    // Compiled data of each entry in RuntimeEmotions
+    mutable TArray<FEmotionCompiledEmotion> CompiledEmotions;
+
+    // Intensity brackets of all compiled emotions, flattened
+    mutable TArray<FEmotionCompiledBracket> CompiledBrackets;
+
+    // Links of all compiled emotions, their grid cells and variation tags, flattened
+    mutable TArray<FEmotionCompiledLink> CompiledLinks;
+    mutable TArray<uint8> CompiledLinkCells;
+    mutable TArray<FGameplayTag> CompiledLinkVariations;
+
+    mutable FEmotionSpatialIndex SpatialIndex;
+
+    mutable FEmotionZoneTable ZoneTable;
+
+    mutable FEmotionTagSpace TagSpace;
+
+    mutable FEmotionCombinationTable CombinationTable;
+
+    // Data revision the runtime data was compiled against, 0 means never compiled
+    mutable uint32 CompiledRevision = 0;
+
+    // Set by BuildRuntimeData, masks built in an older tag space carry a different id
+    uint32 CompileId = 0;
 };
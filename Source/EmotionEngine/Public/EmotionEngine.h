@@ -3,6 +3,21 @@
 #pragma once
 
 #include "Modules/ModuleManager.h"
+#include "Stats/Stats.h"
+#include "HAL/LowLevelMemTracker.h"
+
+// Memory of the emotion system by category, refreshed by UEmotionSubsystem while stats are collected (stat EmotionEngine)
+DECLARE_STATS_GROUP(TEXT("EmotionEngine"), STATGROUP_EmotionEngine, STATCAT_Advanced);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Libraries"), STAT_EmotionLibraryMemory, STATGROUP_EmotionEngine, EMOTIONENGINE_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Agent States"), STAT_EmotionAgentStateMemory, STATGROUP_EmotionEngine, EMOTIONENGINE_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Indexes"), STAT_EmotionIndexMemory, STATGROUP_EmotionEngine, EMOTIONENGINE_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Queues"), STAT_EmotionQueueMemory, STATGROUP_EmotionEngine, EMOTIONENGINE_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Tag Sets"), STAT_EmotionTagSetMemory, STATGROUP_EmotionEngine, EMOTIONENGINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Agents"), STAT_EmotionAgents, STATGROUP_EmotionEngine, EMOTIONENGINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pooled States"), STAT_EmotionPooledStates, STATGROUP_EmotionEngine, EMOTIONENGINE_API);
+
+// Low level memory tracker tag for allocations made by the emotion system (-llm, stat LLM)
+LLM_DECLARE_TAG_API(EmotionEngine, EMOTIONENGINE_API);
 
 class FEmotionEngineModule : public IModuleInterface
 {
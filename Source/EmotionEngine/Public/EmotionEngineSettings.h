@@ -0,0 +1,29 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "EmotionEngineSettings.generated.h"
+
+/**
+ * Project settings of the emotion system (Project Settings > Plugins > Emotion Engine)
+ */
+UCLASS(Config = Game, DefaultConfig, meta = (DisplayName = "Emotion Engine"))
+class EMOTIONENGINE_API UEmotionEngineSettings : public UDeveloperSettings
+{
+    GENERATED_BODY()
+
+public:
+    UEmotionEngineSettings();
+
+    // Cook emotion definitions for server-only platforms without display names, descriptions and icon references,
+    // so dedicated servers never load emotion icons or keep UI text in memory
+    UPROPERTY(Config, EditAnywhere, Category = "Cooking")
+    bool bStripPresentationDataForServer;
+
+    // Asset bundles loaded with emotion libraries that are streamed in at runtime (the default library and
+    // UEmotionComponent::StreamedEmotionLibrary), e.g. "UI" to bring in the emotion icons with the library
+    UPROPERTY(Config, EditAnywhere, Category = "Streaming")
+    TArray<FName> LibraryLoadBundles;
+
+    virtual FName GetCategoryName() const override { return TEXT("Plugins"); }
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Emotion found by a spatial query, with its squared distance in VA space
+ */
+struct EMOTIONENGINE_API FEmotionNeighbor
+{
+    float DistanceSquared = 0.0f;
+
+    // Index of the emotion in the indexed coordinates
+    int32 EmotionIndex = INDEX_NONE;
+
+    FEmotionNeighbor() {}
+
+    FEmotionNeighbor(float InDistanceSquared, int32 InEmotionIndex)
+        : DistanceSquared(InDistanceSquared), EmotionIndex(InEmotionIndex) {}
+
+    // Closest first, ties in index order so results do not depend on the grid layout
+    FORCEINLINE bool operator<(const FEmotionNeighbor& Other) const
+    {
+        return DistanceSquared < Other.DistanceSquared || (DistanceSquared == Other.DistanceSquared && EmotionIndex < Other.EmotionIndex);
+    }
+};
+
+/**
+ * Spatial index over the VA coordinates of a library's emotions, compiled with the library.
+ * A uniform grid answers radius queries from the cells overlapping the query circle only. A neighbor graph keeps each
+ * emotion's neighbors within AdjacencyRadius sorted by distance, so adjacency queries up to that radius are a prefix
+ * of a precomputed list and never sort. A fine lookup grid over the VA plane holds the nearest emotion of every cell,
+ * cells crossed by a border between two emotions' regions keep the few emotions that can be nearest inside them.
+ */
+struct EMOTIONENGINE_API FEmotionSpatialIndex
+{
+    // Neighbors are precomputed up to this distance (the default of UEmotionLibrary::GetAdjacentEmotions), every smaller radius reads a prefix
+    static constexpr float AdjacencyRadius = 0.3f;
+
+    // Cells per axis are capped so sparse outliers do not blow up the grid
+    static constexpr int32 MaxCellsPerAxis = 64;
+
+    // Cells per axis of the nearest emotion lookup grid
+    static constexpr int32 NearestGridResolution = 256;
+
+    // Smaller sets are scanned instead, the scan is as fast as the lookup and the grid is not worth its memory
+    static constexpr int32 MinEmotionsForNearestGrid = 32;
+
+    // Index the coordinates, emotion indices in query results are indices into this array
+    void Build(TConstArrayView<FVector2D> InCoordinates);
+
+    void Reset();
+
+    // Emotions within Radius of a point, closest first
+    void FindInRadius(const FVector2D& Center, float Radius, TArray<FEmotionNeighbor>& OutNeighbors) const;
+
+    // Emotions within MaxDistance of an indexed emotion, closest first, the emotion itself excluded
+    void FindAdjacent(int32 EmotionIndex, float MaxDistance, TArray<FEmotionNeighbor>& OutNeighbors) const;
+
+    // Precomputed neighbors of an indexed emotion within AdjacencyRadius, closest first
+    TConstArrayView<FEmotionNeighbor> GetNeighbors(int32 EmotionIndex) const;
+
+    // Closest emotion to a point, INDEX_NONE if nothing is indexed. Exact, ties go to the lowest index like the scan.
+    int32 FindNearest(const FVector2D& Point) const;
+
+    // Closest emotion to the center of the lookup cell containing the point, constant time. Can differ from FindNearest
+    // near the border of two emotions' regions, by at most one cell diagonal in distance.
+    int32 FindNearestApproximate(const FVector2D& Point) const;
+
+    // Scan of every emotion, reference for FindNearest and used outside the lookup grid
+    int32 FindNearestBruteForce(const FVector2D& Point) const;
+
+    FORCEINLINE bool HasNearestGrid() const { return NearestCells.Num() > 0; }
+
+    FORCEINLINE int32 Num() const { return Coordinates.Num(); }
+
+    // Heap memory used by the grids and the neighbor graph
+    SIZE_T GetAllocatedSize() const;
+
+private:
+    // Indexed coordinates, in emotion index order
+    TArray<FVector2D> Coordinates;
+
+    // Grid covering the bounds of the coordinates
+    FVector2D GridOrigin = FVector2D::ZeroVector;
+    float InvCellSize = 1.0f;
+    int32 CellsX = 0;
+    int32 CellsY = 0;
+
+    // Emotion indices grouped by cell, the entries of cell i are CellEntries[CellStarts[i], CellStarts[i + 1])
+    TArray<int32> CellStarts;
+    TArray<int32> CellEntries;
+
+    // Neighbor graph, the neighbors of emotion i are Neighbors[NeighborStarts[i], NeighborStarts[i + 1])
+    TArray<int32> NeighborStarts;
+    TArray<FEmotionNeighbor> Neighbors;
+
+    // Nearest emotion lookup grid covering at least [-1, 1] on both axes and the bounds of the emotions
+    FVector2D NearestGridOrigin = FVector2D::ZeroVector;
+    double NearestInvCellSize = 1.0;
+
+    // Set on cells where more than one emotion can be nearest
+    static constexpr uint32 AmbiguousCellFlag = 1u << 31;
+
+    // Per cell: the emotion nearest everywhere in the cell, or AmbiguousCellFlag | offset of the cell's run in NearestCandidates
+    TArray<uint32> NearestCells;
+
+    // Runs of [NumCandidates, emotion nearest to the cell center, candidates in index order...]
+    TArray<uint16> NearestCandidates;
+
+    void BuildNearestGrid(const FBox2D& Bounds);
+
+    // Lookup cell of a point, false if the point is outside the grid
+    bool GetNearestCell(const FVector2D& Point, int32& OutCell) const;
+
+    // Clamped cell coordinate of a point on one axis
+    FORCEINLINE int32 GetCellX(double X) const { return FMath::Clamp(FMath::FloorToInt32((X - GridOrigin.X) * InvCellSize), 0, CellsX - 1); }
+    FORCEINLINE int32 GetCellY(double Y) const { return FMath::Clamp(FMath::FloorToInt32((Y - GridOrigin.Y) * InvCellSize), 0, CellsY - 1); }
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Unit mass spring-damper used to move an emotion state's VA coordinate toward the target pulled by its active emotions.
+ * Integrated with a semi-implicit (backward Euler) step, which is unconditionally stable: long LOD ticks and hitches
+ * only add numerical damping, so a large DeltaTime settles toward the target instead of overshooting or diverging.
+ */
+struct EMOTIONENGINE_API FEmotionSpring
+{
+    /**
+     * Advance a single spring
+     * @param Position - Current VA coordinate, updated in place
+     * @param Velocity - Current VA velocity, updated in place
+     * @param Target - VA coordinate the spring pulls toward
+     * @param Stiffness - Spring constant, higher responds faster
+     * @param Damping - Damping coefficient, critical damping is 2 * sqrt(Stiffness)
+     * @param DeltaTime - Step length in seconds, any non-negative value is stable
+     */
+    static FORCEINLINE void Step(FVector2D& Position, FVector2D& Velocity, const FVector2D& Target, float Stiffness, float Damping, float DeltaTime)
+    {
+        // Solve v' = (v - dt * k * (x - t)) / (1 + dt * c + dt^2 * k), then x' = x + dt * v'
+        const float InvDenominator = 1.0f / (1.0f + DeltaTime * Damping + DeltaTime * DeltaTime * Stiffness);
+        Velocity = (Velocity - (Position - Target) * (DeltaTime * Stiffness)) * InvDenominator;
+        Position += Velocity * DeltaTime;
+    }
+
+    /**
+     * Advance many springs stored as structure of arrays, same math as Step.
+     * All views must have the same length, the loop carries no dependencies between agents and vectorizes.
+     */
+    static void StepBatch(
+        TArrayView<float> PositionX, TArrayView<float> PositionY,
+        TArrayView<float> VelocityX, TArrayView<float> VelocityY,
+        TConstArrayView<float> TargetX, TConstArrayView<float> TargetY,
+        TConstArrayView<float> Stiffness, TConstArrayView<float> Damping,
+        float DeltaTime);
+};
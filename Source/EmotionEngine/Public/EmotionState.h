@@ -4,39 +4,18 @@
 #include "GameplayTagContainer.h"
 #include "EmotionData.h"
 #include "Emotion.h"
+#include "EmotionTagMask.h"
+#include "EmotionStateData.h"
+#include "EmotionStatePool.h"
 #include "EmotionState.generated.h"
 
 // Forward declare UEmotionLibrary
 class UEmotionLibrary;
+class UEmotionSubsystem;
 
 /**
- * Struct to track an active emotion in the emotion state
- */
-USTRUCT(BlueprintType)
-struct EMOTIONENGINE_API FActiveEmotion
-{
-    GENERATED_USTRUCT_BODY()
-public:
-    // The emotion data asset
-    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="EmotionSystem")
-    TObjectPtr<UEmotionDefinition> EmotionData;
-    
-    // Current intensity of this emotion (0.0 to 100.0)
-    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="EmotionSystem")
-    float Intensity;
-    
-    // Time this emotion was last updated
-    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="EmotionSystem")
-    float LastUpdateTime;
-    
-    FActiveEmotion() : EmotionData(nullptr), Intensity(0.0f), LastUpdateTime(0.0f) {}
-    
-    FActiveEmotion(UEmotionDefinition* InEmotionData, float InIntensity, float InTime)
-        : EmotionData(InEmotionData), Intensity(InIntensity), LastUpdateTime(InTime) {}
-};
-
-/**
- * Manages the emotional state of an actor, including active emotions and VA coordinates
+ * Blueprint facing emotional state of an actor, including active emotions and VA coordinates.
+ * Either owns its FEmotionStateData, or is a view of a state in the subsystem's state pool.
  */
 UCLASS(BlueprintType)
 class EMOTIONENGINE_API UEmotionState : public UObject
@@ -45,26 +24,38 @@ class EMOTIONENGINE_API UEmotionState : public UObject
 
 public:
     UEmotionState();
-    
-    // Called every frame to update emotion state
+
+    // Called every frame to update emotion state, pooled states are ticked by the subsystem instead
     UFUNCTION(BlueprintCallable, Category="EmotionSystem")
     void Tick(float DeltaTime);
-    
+
     // Initialize the state with the Emotion Library
     UFUNCTION(BlueprintCallable, Category="EmotionSystem")
     void Initialize(UEmotionLibrary* InEmotionLibrary);
 
     // The gameplay tags representing all emotion in the state, include range and combined emotions
-    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="EmotionSystem")
-    FGameplayTagContainer EmotionTags;
-    
+    UFUNCTION(BlueprintCallable, Category="EmotionSystem")
+    FGameplayTagContainer GetEmotionTags() const;
+
     // Current Valence-Arousal coordinate of the emotional state
-    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="EmotionSystem")
-    FVector2D VACoordinate;
-    
+    UFUNCTION(BlueprintCallable, Category="EmotionSystem")
+    FVector2D GetVACoordinate() const;
+
+    // Set the Valence-Arousal coordinate directly
+    UFUNCTION(BlueprintCallable, Category="EmotionSystem")
+    void SetVACoordinate(const FVector2D& NewVACoordinate);
+
     // Radius of influence in the VA space
-    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="EmotionSystem", meta=(ClampMin="0.0"))
-    float InfluenceRadius;
+    UFUNCTION(BlueprintCallable, Category="EmotionSystem")
+    float GetInfluenceRadius() const;
+
+    // Set the radius of influence in the VA space
+    UFUNCTION(BlueprintCallable, Category="EmotionSystem")
+    void SetInfluenceRadius(float NewRadius);
+
+    // Spring settings of the VA coordinate (higher stiffness = faster response, 2 * sqrt(Stiffness) damping is critical)
+    UFUNCTION(BlueprintCallable, Category="EmotionSystem")
+    void SetSpringParameters(float Stiffness, float Damping);
 
     // Get an emotion tag intensity
     UFUNCTION(BlueprintCallable, Category="EmotionSystem")
@@ -81,41 +72,60 @@ public:
     // Set intensity for an emotion
     UFUNCTION(BlueprintCallable, Category="EmotionSystem")
     void SetIntensity(const FGameplayTag& InTag, float InIntensity);
-    
+
     // Get all active emotions
     UFUNCTION(BlueprintCallable, Category="EmotionSystem")
     TArray<FActiveEmotion> GetActiveEmotions() const;
-    
+
     // Get the dominant emotion (highest intensity)
     UFUNCTION(BlueprintCallable, Category="EmotionSystem")
     void GetDominantEmotion(FGameplayTag& OutEmotionTag, float& OutIntensity) const;
-    
+
     // Find emotions within a certain radius in the VA space
     UFUNCTION(BlueprintCallable, Category="EmotionSystem")
     TArray<UEmotionDefinition*> FindEmotionsInRadius(float Radius) const;
 
+    // Check if the state carries an emotion tag (parents of carried tags match as well)
+    UFUNCTION(BlueprintCallable, Category="EmotionSystem")
+    bool HasEmotionTag(const FGameplayTag& InTag) const;
+
+    // Check if the state carries any of the given emotion tags
+    UFUNCTION(BlueprintCallable, Category="EmotionSystem")
+    bool HasAnyEmotionTags(const FGameplayTagContainer& InTags) const;
+
+    // Check if the state carries all of the given emotion tags
+    UFUNCTION(BlueprintCallable, Category="EmotionSystem")
+    bool HasAllEmotionTags(const FGameplayTagContainer& InTags) const;
+
+    // Defer derived state (emotion tags) rebuilds until the matching EndBatch, batches can be nested. C++ only, a batch
+    // left open by an early return would stall the tags, Blueprints use UEmotionComponent::ApplyEmotionDeltas instead
+    void BeginBatch();
+
+    // End a batch started with BeginBatch, the outermost call rebuilds the derived state once
+    void EndBatch();
+
+    // Get the emotion library this state was initialized with
+    UEmotionLibrary* GetEmotionLibrary() const;
+
+    // Make this object a view of a pooled state instead of its own
+    void BindToPooledState(UEmotionSubsystem* InStatePoolOwner, const FEmotionStateHandle& InHandle);
+
+    // True if this object views a pooled state
+    bool IsPooledView() const { return PooledStateHandle.IsValid(); }
+
+    // The viewed state, null if it was a pooled state that has been released
+    FEmotionStateData* GetStateData();
+    const FEmotionStateData* GetStateData() const;
+
 private:
+    // State owned by this object when it is not a pooled view
     UPROPERTY()
-    TObjectPtr<UEmotionLibrary> EmotionLibraryInstance;
+    FEmotionStateData OwnedState;
 
-    // Map of active emotions (tag -> active emotion struct)
-    UPROPERTY()
-    TMap<FGameplayTag, FActiveEmotion> ActiveEmotions;
-    
-    // Update the VA coordinate based on active emotions using spring model
-    void UpdateVACoordinate(float DeltaTime);
-    
-    // Apply decay to all active emotions
-    void ApplyDecay(float DeltaTime);
-    
-    // Update emotion tags based on active emotions
-    void UpdateEmotionTags();
-    
-    // Handle opposite emotions (adding to one reduces the other)
-    // Handle opposite emotions (adding to one reduces the other)
-    // Currently disabled but kept for future use
-    void HandleOppositeEmotions(const FGameplayTag& InTag, float InIntensity);
-    
-    // Check for and process emotion combinations
-    void ProcessEmotionCombinations();
-};
\ No newline at end of file
+    // Pooled state viewed by this object
+    FEmotionStateHandle PooledStateHandle;
+    TWeakObjectPtr<UEmotionSubsystem> StatePoolOwner;
+
+    // World time used to stamp changes
+    float GetCurrentTime() const;
+};
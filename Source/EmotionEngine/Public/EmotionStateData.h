@@ -0,0 +1,265 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "EmotionData.h"
+#include "EmotionTagMask.h"
+#include "EmotionTagSetTable.h"
+#include "EmotionStateData.generated.h"
+
+class UEmotionLibrary;
+
+/**
+ * Blueprint view of an active emotion, resolved from the state's library when requested
+ */
+USTRUCT(BlueprintType)
+struct EMOTIONENGINE_API FActiveEmotion
+{
+    GENERATED_USTRUCT_BODY()
+public:
+    // The emotion data asset
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="EmotionSystem")
+    TObjectPtr<UEmotionDefinition> EmotionData;
+
+    // Current intensity of this emotion (0.0 to 100.0)
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="EmotionSystem")
+    float Intensity;
+
+    // Time this emotion has decayed up to, shared by all emotions of a state
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="EmotionSystem")
+    float LastUpdateTime;
+
+    FActiveEmotion() : EmotionData(nullptr), Intensity(0.0f), LastUpdateTime(0.0f) {}
+
+    FActiveEmotion(UEmotionDefinition* InEmotionData, float InIntensity, float InTime)
+        : EmotionData(InEmotionData), Intensity(InIntensity), LastUpdateTime(InTime) {}
+};
+
+/**
+ * Quantized record of an active emotion, 4 bytes. References its definition by index into the library's
+ * runtime emotions, so active emotions hold no UObject references for the garbage collector to traverse.
+ */
+struct EMOTIONENGINE_API FEmotionCompactEntry
+{
+    // Steps of the fixed-point intensity per intensity point, 0..100 maps onto the full uint16 range
+    static constexpr float IntensityScale = MAX_uint16 / 100.0f;
+
+    // Index of the emotion in UEmotionLibrary::GetRuntimeEmotions
+    uint16 EmotionIndex = 0;
+
+    // Fixed-point intensity, see IntensityScale
+    uint16 QuantizedIntensity = 0;
+
+    FEmotionCompactEntry() {}
+
+    FEmotionCompactEntry(int32 InEmotionIndex, float InIntensity)
+        : EmotionIndex(static_cast<uint16>(InEmotionIndex)), QuantizedIntensity(QuantizeIntensity(InIntensity)) {}
+
+    float GetIntensity() const { return QuantizedIntensity / IntensityScale; }
+    void SetIntensity(float InIntensity) { QuantizedIntensity = QuantizeIntensity(InIntensity); }
+
+    // Subtract an intensity amount in fixed point, so the step isn't rounded through float intensity first
+    void Decay(float InAmount, float Dither)
+    {
+        QuantizedIntensity = static_cast<uint16>(FMath::Clamp(FMath::FloorToInt32(QuantizedIntensity - InAmount * IntensityScale + Dither), 0, int32(MAX_uint16)));
+    }
+
+    // Round to the nearest step, Dither in [0,1) replaces the rounding offset so repeated small decrements don't stall
+    static uint16 QuantizeIntensity(float InIntensity, float Dither = 0.5f)
+    {
+        return static_cast<uint16>(FMath::Clamp(FMath::FloorToInt32(InIntensity * IntensityScale + Dither), 0, int32(MAX_uint16)));
+    }
+};
+
+/**
+ * Emotional state of one agent: active emotions, derived emotion tags and the VA coordinate.
+ * Plain struct so it can live either inside a UEmotionState or in the subsystem's FEmotionStatePool,
+ * callers pass the current world time since the struct has no world context of its own.
+ *
+ * Storage is quantized to keep crowds cheap: intensities are 16 bit fixed point, all active emotions share one
+ * decay time base and the VA coordinate is an int16 pair. Up to four active emotions are stored inline and the
+ * emotion tags are an interned set shared with every agent carrying the same tags, so a state stays within
+ * BytesPerAgentBudget (100k agents in about 25.6 MB) plus its share of FEmotionTagSetTable.
+ */
+USTRUCT()
+struct EMOTIONENGINE_API FEmotionStateData
+{
+    GENERATED_BODY()
+
+public:
+    // Bytes per agent, sizeof(FEmotionStateData) is checked at compile time and the footprint of 100k pooled states
+    // with their heap storage and tag sets by the EmotionEngine.StateData.MemoryBudget100k automation test
+    static constexpr SIZE_T BytesPerAgentBudget = 256;
+
+    // Active emotions stored without a heap allocation
+    static constexpr int32 NumInlineEmotions = 4;
+
+    // Steps of the quantized VA coordinate per unit, the coordinate is clamped to [-1,1] on both axes
+    static constexpr float VACoordinateScale = MAX_int16;
+
+    // Quantization steps two VA coordinates may differ by on each axis and still count as the same resting coordinate
+    static constexpr int32 VARestToleranceSteps = 1;
+
+    FEmotionStateData();
+
+    // Initialize the state with the Emotion Library, clears all emotions
+    void Initialize(UEmotionLibrary* InEmotionLibrary);
+
+    // Return to a default constructed state without a library, keeping the storage for reuse
+    void Reset();
+
+    // Heap memory owned by the state, zero while its emotions fit inline. The interned tag set is accounted by FEmotionTagSetTable.
+    SIZE_T GetAllocatedSize() const { return ActiveEmotions.GetAllocatedSize() + PendingCombinations.GetAllocatedSize(); }
+
+    // Advance decay, VA coordinate, combinations and emotion tags
+    void Tick(float DeltaTime, float CurrentTime);
+
+    // Become a copy of a shared baseline state, its emotions start decaying at CurrentTime
+    void InitializeFromBaseline(const FEmotionStateData& Baseline, float CurrentTime);
+
+    // True if the state holds the same emotions, tags and settings as the baseline and its VA coordinate rests within
+    // VARestToleranceSteps of the baseline's
+    bool IsEquivalentTo(const FEmotionStateData& Baseline) const;
+
+    // True if nothing is active and the VA coordinate rests at neutral, ticking would not change the state
+    bool IsAtRest() const;
+
+    // Radius of influence in the VA space
+    UPROPERTY()
+    float InfluenceRadius;
+
+    // Spring stiffness pulling the VA coordinate toward the active emotions
+    UPROPERTY()
+    float SpringStiffness;
+
+    // Damping of the VA coordinate movement
+    UPROPERTY()
+    float DampingFactor;
+
+    // The gameplay tags representing all emotion in the state, include range and combined emotions
+    const FGameplayTagContainer& GetEmotionTags() const { return EmotionTagSet.Get().Tags; }
+
+    // Id of the interned emotion tag set, states with equal ids carry equal tags
+    uint32 GetEmotionTagSetId() const { return EmotionTagSet.GetId(); }
+
+    // Current Valence-Arousal coordinate of the emotional state
+    FVector2D GetVACoordinate() const;
+    void SetVACoordinate(const FVector2D& NewVACoordinate);
+
+    // Current velocity of the VA coordinate in the spring model
+    FVector2D GetVAVelocity() const { return FVector2D(VAVelocity); }
+    void SetVAVelocity(const FVector2D& NewVAVelocity) { VAVelocity = FVector2f(NewVAVelocity); }
+
+    float GetIntensity(const FGameplayTag& InTag) const;
+    void AddEmotion(const FGameplayTag& InTag, float InIntensity, float CurrentTime);
+    void RemoveEmotion(const FGameplayTag& InTag);
+    void SetIntensity(const FGameplayTag& InTag, float InIntensity, float CurrentTime);
+
+    TArray<FActiveEmotion> GetActiveEmotions() const;
+    void ForEachActiveEmotion(TFunctionRef<void(const FGameplayTag&, float)> Visitor) const;
+    void GetDominantEmotion(FGameplayTag& OutEmotionTag, float& OutIntensity) const;
+    TArray<UEmotionDefinition*> FindEmotionsInRadius(float Radius) const;
+
+    bool HasEmotionTag(const FGameplayTag& InTag) const;
+    bool MatchesAnyEmotionTags(const FEmotionTagQueryMask& Query) const;
+    bool MatchesAllEmotionTags(const FEmotionTagQueryMask& Query) const;
+
+    // Defer emotion tag rebuilds until the matching EndBatch, every change in the batch uses CurrentTime
+    void BeginBatch(float CurrentTime);
+    void EndBatch();
+
+    UEmotionLibrary* GetEmotionLibrary() const { return EmotionLibrary; }
+
+private:
+    friend class FEmotionStatePool;
+
+    // Kept alive by the owning UEmotionState, or by the subsystem for pooled states
+    UPROPERTY()
+    TObjectPtr<UEmotionLibrary> EmotionLibrary;
+
+    // Active emotions, at most one entry per runtime emotion index
+    TArray<FEmotionCompactEntry, TInlineAllocator<NumInlineEmotions>> ActiveEmotions;
+
+    // Interned emotion tags, with their bit set form in the library's tag space
+    FEmotionTagSetRef EmotionTagSet;
+
+    // Combinations of the library's combination table that need to be re-evaluated on the next tick
+    TBitArray<> PendingCombinations;
+
+    // Velocity of the VA coordinate, kept in float since small velocities would vanish when quantized
+    FVector2f VAVelocity = FVector2f::ZeroVector;
+
+    // Quantized VA coordinate, see VACoordinateScale
+    int16 QuantizedVA[2] = { 0, 0 };
+
+    // Time every active emotion has decayed up to
+    float DecayTimeBase = 0.0f;
+
+    // Time shared by every change made inside the current batch
+    float BatchTime = 0.0f;
+
+    // Nesting depth of BeginBatch calls
+    uint8 BatchDepth = 0;
+
+    // Advances every decay step to pick the next dither offset
+    uint8 DecayDitherIndex = 0;
+
+    // Set when an emotion entered, left or crossed into another intensity bracket, the tags are rebuilt right away
+    // outside batches, at the end of the outermost batch and at the end of a tick
+    bool bEmotionTagsDirty = false;
+
+    // Time stamp for changes, the batch time while a batch is open
+    float GetChangeTime(float CurrentTime) const { return BatchDepth > 0 ? BatchTime : CurrentTime; }
+
+    // Entry of the runtime emotion with the given index, or nullptr if it isn't active
+    FEmotionCompactEntry* FindEntry(int32 EmotionIndex);
+    const FEmotionCompactEntry* FindEntry(int32 EmotionIndex) const;
+
+    // Tag of an active entry
+    FGameplayTag GetEntryTag(const FEmotionCompactEntry& Entry) const;
+
+    // Insert a new entry, the decay time base restarts when the state had no active emotions
+    void AddEntry(int32 EmotionIndex, float InIntensity, float ChangeTime);
+
+    // Rebuild emotion tags if a change made them stale, now or once at the end of the current batch
+    void RequestEmotionTagsUpdate();
+
+    // Change an entry's intensity, the tags are only flagged stale if the intensity moves to another bracket
+    void SetEntryIntensity(FEmotionCompactEntry& Entry, float InIntensity);
+
+    // Intensity weighted average of the active emotions' VA coordinates, or neutral if none are active
+    FVector2D CalculateTargetVACoordinate() const;
+
+    // True if the VA coordinate already rests on the target and needs no integration
+    bool IsVACoordinateAtRest(const FVector2D& TargetVA) const;
+
+    // Store the result of a spring step toward TargetVA. Steps smaller than half a quantization step round back, so a
+    // stalled axis moves one step while the spring still pulls it toward the target, and the spring stops once the
+    // coordinate sits on the target's step with a velocity too small to leave it.
+    void ApplySpringStep(const FVector2D& NewVACoordinate, const FVector2D& NewVelocity, const FVector2D& TargetVA, float DeltaTime);
+
+    // One axis of a VA coordinate in quantized steps, clamped to [-1,1]
+    static int16 QuantizeVAAxis(double Value);
+
+    // Apply decay to all active emotions
+    void ApplyDecay(float CurrentTime);
+
+    // Update emotion tags based on active emotions
+    void UpdateEmotionTags();
+
+    // Handle opposite emotions (adding to one reduces the other)
+    // Currently disabled but kept for future use
+    void HandleOppositeEmotions(const FGameplayTag& InTag, float InIntensity, float CurrentTime);
+
+    // Check for and process emotion combinations affected by changes since the last tick
+    void ProcessEmotionCombinations(float CurrentTime);
+
+    // Flag the combinations that depend on an emotion for re-evaluation
+    void MarkEmotionChanged(const FGameplayTag& InTag);
+
+    // Check if every trigger of a combination is present in the active emotions
+    bool AreCombinationTriggersActive(const FEmotionCompiledCombination& Combination, const FEmotionTagMask& ActiveEmotionMask) const;
+};
+
+static_assert(sizeof(FEmotionCompactEntry) == 4, "FEmotionCompactEntry must stay 4 bytes");
+static_assert(sizeof(FEmotionStateData) <= FEmotionStateData::BytesPerAgentBudget, "FEmotionStateData exceeds its bytes-per-agent budget");
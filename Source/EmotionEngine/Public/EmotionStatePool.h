@@ -0,0 +1,84 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EmotionStateData.h"
+
+/**
+ * Handle to a state in an FEmotionStatePool.
+ * The generation makes handles to released slots fail to resolve instead of aliasing the slot's next owner.
+ */
+struct EMOTIONENGINE_API FEmotionStateHandle
+{
+    int32 Index = INDEX_NONE;
+    uint32 Generation = 0;
+
+    bool IsValid() const { return Index != INDEX_NONE; }
+
+    void Invalidate()
+    {
+        Index = INDEX_NONE;
+        Generation = 0;
+    }
+
+    bool operator==(const FEmotionStateHandle& Other) const
+    {
+        return Index == Other.Index && Generation == Other.Generation;
+    }
+};
+
+/**
+ * Contiguous storage for emotion states addressed by handle, owned by the UEmotionSubsystem.
+ * Pooled states are not UObjects, so they add nothing for the garbage collector to trace,
+ * and they are ticked together with the spring step run over all of them as one batch.
+ * The pool does not keep emotion libraries alive, its owner has to reference them.
+ */
+class EMOTIONENGINE_API FEmotionStatePool
+{
+public:
+    // Take a free slot and initialize it with the library
+    FEmotionStateHandle Allocate(UEmotionLibrary* Library);
+
+    // Take Count slots in one pass and fill each with a copy of Source, decaying from CurrentTime. Handles are appended to OutHandles.
+    void AllocateCopies(const FEmotionStateData& Source, float CurrentTime, int32 Count, TArray<FEmotionStateHandle>& OutHandles);
+
+    // Make room for NumStates live states, so allocating up to that many does not grow the storage
+    void Reserve(int32 NumStates);
+
+    // Return a slot to the pool, outstanding copies of the handle stop resolving
+    void Release(const FEmotionStateHandle& Handle);
+
+    // Resolve a handle, null if it was released. Pointers are invalidated by the next Allocate.
+    FEmotionStateData* Get(const FEmotionStateHandle& Handle);
+    const FEmotionStateData* Get(const FEmotionStateHandle& Handle) const;
+
+    // Advance every live state
+    void Tick(float DeltaTime, float CurrentTime);
+
+    // Release every state
+    void Reset();
+
+    // Number of live states
+    int32 Num() const { return States.Num() - FreeIndices.Num(); }
+
+    // Memory of every slot, live or free, and the slot bookkeeping
+    SIZE_T GetAllocatedSize() const;
+
+    // Memory of the scratch arrays reused by Tick
+    SIZE_T GetScratchAllocatedSize() const;
+
+private:
+    TArray<FEmotionStateData> States;
+
+    // Bumped on every release
+    TArray<uint32> Generations;
+
+    TBitArray<> LiveStates;
+    TArray<int32> FreeIndices;
+
+    // Free slot, or a new one at the end, marked live
+    FEmotionStateHandle AllocateSlot();
+
+    // Structure of arrays scratch for the batched spring step, kept to avoid reallocating every tick
+    TArray<int32> SpringStates;
+    TArray<float> PositionX, PositionY, VelocityX, VelocityY, TargetX, TargetY, Stiffness, Damping;
+};
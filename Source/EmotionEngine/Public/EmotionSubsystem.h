@@ -3,18 +3,49 @@
 #include "CoreMinimal.h"
 #include "Subsystems/WorldSubsystem.h"
 #include "GameplayTagContainer.h"
+#include "Engine/StreamableManager.h"
+#include "EmotionStatePool.h"
+#include "EmotionTagSetTable.h"
 #include "EmotionSubsystem.generated.h"
 
 class UEmotionComponent;
 class UEmotionLibrary;
 class UEmotionDefinition;
+class UEmotionArchetype;
+struct FEmotionChange;
+
+/**
+ * Memory used by the emotion system in one world, by category
+ */
+struct EMOTIONENGINE_API FEmotionMemoryStats
+{
+	// Libraries used by the world's agents: authored arrays and compiled runtime data
+	SIZE_T LibraryBytes = 0;
+
+	// Pooled state slots, standalone states and archetype baselines
+	SIZE_T AgentStateBytes = 0;
+
+	// Registration and pooled component lookups
+	SIZE_T IndexBytes = 0;
+
+	// Batch and notification bookkeeping, tick scratch arrays
+	SIZE_T QueueBytes = 0;
+
+	// Interned emotion tag sets, shared by every world
+	SIZE_T TagSetBytes = 0;
+
+	int32 NumAgents = 0;
+	int32 NumPooledStates = 0;
+
+	SIZE_T GetTotalBytes() const { return LibraryBytes + AgentStateBytes + IndexBytes + QueueBytes + TagSetBytes; }
+};
 
 /**
  * Subsystem for tracking and querying EmotionComponents with emotion tags
- * Provides global access to emotion system functionality
+ * Provides global access to emotion system functionality and owns the pooled emotion states
  */
 UCLASS()
-class EMOTIONENGINE_API UEmotionSubsystem : public UWorldSubsystem
+class EMOTIONENGINE_API UEmotionSubsystem : public UTickableWorldSubsystem
 {
 	GENERATED_BODY()
 
@@ -24,15 +55,38 @@ public:
 	virtual void Deinitialize() override;
 	// End USubsystem
 
+	// Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject
+
+	// Allocate a pooled emotion state for a component, ticked by this subsystem until released
+	FEmotionStateHandle AcquirePooledState(UEmotionComponent* Component, UEmotionLibrary* Library);
+
+	// Return a component's pooled state to the pool
+	void ReleasePooledState(UEmotionComponent* Component, const FEmotionStateHandle& Handle);
+
+	// Storage of all pooled emotion states
+	FEmotionStatePool& GetStatePool() { return StatePool; }
+	const FEmotionStatePool& GetStatePool() const { return StatePool; }
+
 	// Register an EmotionComponent with the subsystem
 	void RegisterEmotionComponent(UEmotionComponent* Component);
 
 	// Unregister an EmotionComponent from the subsystem
 	void UnregisterEmotionComponent(UEmotionComponent* Component);
 
+	// Initialize and register a crowd of freshly spawned components in one pass, call between deferred spawning and
+	// FinishSpawning. Pooled components sharing a library get their states in one allocation, copied from the archetype
+	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
+	void InitializeEmotionComponents(const TArray<UEmotionComponent*>& Components, UEmotionArchetype* Archetype = nullptr);
+
 	// Notify the subsystem that an emotion has changed in a component
 	void NotifyEmotionChanged(UEmotionComponent* Component, const FGameplayTag& EmotionTag, float Intensity);
 
+	// Notify the subsystem of a coalesced set of emotion changes in a component
+	void NotifyEmotionsChanged(UEmotionComponent* Component, const TArray<FEmotionChange>& Changes);
+
 	// Get all EmotionComponents in the world
 	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
 	TArray<UEmotionComponent*> GetAllEmotionComponents() const;
@@ -49,6 +103,15 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
 	TArray<UEmotionComponent*> FindComponentsWithAllEmotionTags(const FGameplayTagContainer& EmotionTags) const;
 
+	// Registered components grouped by interned emotion tag set id
+	TMap<uint32, TArray<UEmotionComponent*>> GroupComponentsByEmotionTagSet() const;
+
+	// Sharing and memory figures of the interned emotion tag sets
+	FEmotionTagSetStats GetEmotionTagSetStats() const;
+
+	// Memory used by the emotion system in this world, walks every registered component
+	FEmotionMemoryStats GetMemoryStats() const;
+
 	// Find the closest EmotionComponent with a specific emotion tag
 	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
 	UEmotionComponent* FindClosestComponentWithEmotionTag(const FGameplayTag& EmotionTag, const FVector& Location, float MaxDistance = 0.0f) const;
@@ -79,18 +142,38 @@ public:
 	void ApplyEmotionalInfluenceToTag(AActor* Influencer, const FGameplayTag& TargetTag, 
 		const FGameplayTag& EmotionTag, float Intensity, bool bAdditive = true);
 
-	// Get the default emotion library
+	// Get the default emotion library of this world, preloaded asynchronously when the subsystem starts. Null while the
+	// load is in flight, components asking for it meanwhile buffer their stimuli until it arrives.
 	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
 	UEmotionLibrary* GetDefaultEmotionLibrary() const;
 
-	// Set the default emotion library
+	// Set the default emotion library, replaces the preloaded one until the next hot reload
 	UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
 	void SetDefaultEmotionLibrary(UEmotionLibrary* NewLibrary);
 
+	// True while the default library is still being loaded
+	bool IsLoadingDefaultEmotionLibrary() const { return DefaultLibraryLoadHandle.IsValid() && DefaultLibraryLoadHandle->IsLoadingInProgress(); }
+
 	// Debug function to log all registered components and their emotions
 	UFUNCTION(BlueprintCallable, Category = "EmotionSystem|Debug")
 	void DebugLogAllEmotions() const;
 
+	// Debug function to log how many emotion tag sets are shared and the memory saved by interning them
+	UFUNCTION(BlueprintCallable, Category = "EmotionSystem|Debug")
+	void DebugLogEmotionTagSetStats() const;
+
+	// Debug function to log emotion memory by category, by archetype and for the agents using the most (console: emotion.MemReport [NumTopAgents])
+	UFUNCTION(BlueprintCallable, Category = "EmotionSystem|Debug")
+	void DebugLogMemoryReport(int32 NumTopAgents = 10) const;
+
+	// Debug function to time the closest emotion lookups of the default library against a scan of every emotion
+	// (console: emotion.BenchmarkClosestEmotion [NumQueries])
+	void DebugBenchmarkClosestEmotion(int32 NumQueries = 100000) const;
+
+	// Debug function to time the batch polar conversions against the scalar ones
+	// (console: emotion.BenchmarkPolarConversions [NumCoordinates])
+	void DebugBenchmarkPolarConversions(int32 NumCoordinates = 100000) const;
+
 	// Debug function to visualize all components' VA coordinates
 	UFUNCTION(BlueprintCallable, Category = "EmotionSystem|Debug")
 	void DebugVisualizeVACoordinates(float Duration = 5.0f) const;
@@ -100,13 +183,59 @@ private:
 	UPROPERTY()
 	TArray<TWeakObjectPtr<UEmotionComponent>> RegisteredComponents;
 
+	// Index of each component in RegisteredComponents
+	TMap<TWeakObjectPtr<UEmotionComponent>, int32> RegisteredComponentIndices;
+
 	// Default emotion library to use if none is specified
 	UPROPERTY()
 	TObjectPtr<UEmotionLibrary> DefaultEmotionLibrary;
 
-	// Helper function to filter components by tag
+	// Load of the default library started by Initialize
+	TSharedPtr<FStreamableHandle> DefaultLibraryLoadHandle;
+
+	// Set by SetDefaultEmotionLibrary, a finishing load does not replace an explicit choice
+	bool bDefaultEmotionLibraryOverridden = false;
+
+	FDelegateHandle ReloadCompleteHandle;
+
+	// Resolve the default library from memory, or start loading it
+	void RequestDefaultEmotionLibrary();
+
+	void OnDefaultEmotionLibraryLoaded();
+
+	// Drop the cached default library after a hot reload and resolve it again
+	void HandleReloadComplete(EReloadCompleteReason Reason);
+
+	// Emotion states of components using pooled state, not traced by the garbage collector
+	FEmotionStatePool StatePool;
+
+	// Libraries referenced by pooled states, kept alive here instead of per state
+	UPROPERTY()
+	TSet<TObjectPtr<UEmotionLibrary>> PooledStateLibraries;
+
+	// Components whose pooled state this subsystem ticks
+	TArray<TWeakObjectPtr<UEmotionComponent>> PooledStateComponents;
+
+	// Index of each component in PooledStateComponents
+	TMap<TWeakObjectPtr<UEmotionComponent>, int32> PooledStateComponentIndices;
+
+	// Copy of PooledStateComponents iterated by Tick, kept to avoid reallocating every frame
+	TArray<TWeakObjectPtr<UEmotionComponent>> PooledComponentsToUpdate;
+
+	// Append a component to an indexed array, false if it was already present
+	static bool AddIndexedComponent(TArray<TWeakObjectPtr<UEmotionComponent>>& Components,
+		TMap<TWeakObjectPtr<UEmotionComponent>, int32>& Indices, UEmotionComponent* Component);
+
+	// Remove a component from an indexed array in constant time, false if it was not present
+	static bool RemoveIndexedComponent(TArray<TWeakObjectPtr<UEmotionComponent>>& Components,
+		TMap<TWeakObjectPtr<UEmotionComponent>, int32>& Indices, UEmotionComponent* Component);
+
+	// Helper function to filter components by tag, the predicate runs once per emotion tag set
 	TArray<UEmotionComponent*> FilterComponentsByTag(TFunctionRef<bool(UEmotionComponent*)> Predicate) const;
 
 	// Helper function to get valid components
 	TArray<UEmotionComponent*> GetValidComponents() const;
+
+	// Push GetMemoryStats into the EmotionEngine stat group
+	void UpdateMemoryStats() const;
 };
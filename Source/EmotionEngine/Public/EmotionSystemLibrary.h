@@ -19,9 +19,22 @@ public:
     // Helper method to get library or default
     static UEmotionLibrary* GetLibraryOrDefault(UEmotionLibrary* ProvidedLibrary);
 
-    // Get the default emotion library asset
+    // Get the default emotion library asset, resolved once and cached. UEmotionSubsystem preloads it asynchronously,
+    // if it is not in memory yet the first call loads it synchronously.
     UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
     static UEmotionLibrary* GetDefaultEmotionLibrary();
+
+    // Path of the default emotion library: the plugin's DefaultEmotionLibrary asset, or the first emotion library
+    // in the asset registry if it does not exist. Resolved from asset registry data once, nothing is loaded.
+    static FSoftObjectPath GetDefaultEmotionLibraryPath();
+
+    // Forget the cached default library and its path, called after a hot reload
+    static void InvalidateDefaultEmotionLibrary();
+
+    // Start streaming in an emotion library with the project's UEmotionEngineSettings::LibraryLoadBundles. Libraries
+    // registered with the asset manager are loaded as primary assets, others as plain soft references. Returns null if
+    // nothing had to be loaded, OnLoaded may then already have been called.
+    static TSharedPtr<FStreamableHandle> LoadEmotionLibraryAsync(const FSoftObjectPath& LibraryPath, FStreamableDelegate OnLoaded);
     
     // FPolarCoordinate to FVector2D
     UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
@@ -83,7 +96,11 @@ public:
     UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
     static void SetStateVACoordinate(UEmotionState* EmotionState, const FVector2D& NewVACoordinate);
     
-    // Find the closest emotion to a VA coordinate
+    // Find the closest emotion to a VA coordinate, bApproximate trades exactness near emotion borders for a constant time lookup
+    UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
+    static UEmotionDefinition* FindClosestEmotion(const FVector2D& VACoordinate, UEmotionLibrary* EmotionLibrary = nullptr, bool bApproximate = false);
+    
+    // Get the core, range and variation zones of the emotion wheel containing a VA coordinate
     UFUNCTION(BlueprintCallable, Category = "EmotionSystem")
-    static UEmotionDefinition* FindClosestEmotion(const FVector2D& VACoordinate, UEmotionLibrary* EmotionLibrary = nullptr);
+    static FEmotionZonePath GetEmotionZonePath(const FVector2D& VACoordinate, UEmotionLibrary* EmotionLibrary = nullptr);
 };
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+
+/**
+ * Fixed-width bit set over the tags of a compiled FEmotionTagSpace.
+ * Masks built through a tag space carry the bits of every parent tag as well,
+ * so hierarchical HasTag/HasAny/HasAll checks reduce to a handful of word-wise AND operations.
+ */
+struct EMOTIONENGINE_API FEmotionTagMask
+{
+    // Maximum number of distinct tags (parents included) a single tag space can hold
+    static constexpr int32 NumBits = 512;
+    static constexpr int32 NumWords = NumBits / 64;
+
+    FEmotionTagMask()
+    {
+        Reset();
+    }
+
+    FORCEINLINE void Reset()
+    {
+        FMemory::Memzero(Words, sizeof(Words));
+    }
+
+    FORCEINLINE void SetBit(int32 Index)
+    {
+        checkSlow(Index >= 0 && Index < NumBits);
+        Words[Index >> 6] |= (uint64(1) << (Index & 63));
+    }
+
+    FORCEINLINE bool TestBit(int32 Index) const
+    {
+        checkSlow(Index >= 0 && Index < NumBits);
+        return (Words[Index >> 6] & (uint64(1) << (Index & 63))) != 0;
+    }
+
+    FORCEINLINE bool IsEmpty() const
+    {
+        uint64 Accum = 0;
+        for (int32 Word = 0; Word < NumWords; ++Word)
+        {
+            Accum |= Words[Word];
+        }
+        return Accum == 0;
+    }
+
+    // True if any bit of Other is also set in this mask
+    FORCEINLINE bool HasAny(const FEmotionTagMask& Other) const
+    {
+        uint64 Accum = 0;
+        for (int32 Word = 0; Word < NumWords; ++Word)
+        {
+            Accum |= Words[Word] & Other.Words[Word];
+        }
+        return Accum != 0;
+    }
+
+    // True if every bit of Other is also set in this mask
+    FORCEINLINE bool HasAll(const FEmotionTagMask& Other) const
+    {
+        uint64 Missing = 0;
+        for (int32 Word = 0; Word < NumWords; ++Word)
+        {
+            Missing |= Other.Words[Word] & ~Words[Word];
+        }
+        return Missing == 0;
+    }
+
+    FORCEINLINE FEmotionTagMask& operator|=(const FEmotionTagMask& Other)
+    {
+        for (int32 Word = 0; Word < NumWords; ++Word)
+        {
+            Words[Word] |= Other.Words[Word];
+        }
+        return *this;
+    }
+
+    FORCEINLINE bool operator==(const FEmotionTagMask& Other) const
+    {
+        return FMemory::Memcmp(Words, Other.Words, sizeof(Words)) == 0;
+    }
+
+    FORCEINLINE bool operator!=(const FEmotionTagMask& Other) const
+    {
+        return !(*this == Other);
+    }
+
+private:
+    alignas(16) uint64 Words[NumWords];
+};
+
+/**
+ * Compiled bit space for the tags referenced by an emotion library.
+ * Each tag gets one bit, and each tag's closure mask contains its own bit plus the bits of all its parents.
+ */
+class EMOTIONENGINE_API FEmotionTagSpace
+{
+public:
+    // Rebuild the space from the given tags, their parents are added automatically
+    void Build(TConstArrayView<FGameplayTag> SourceTags);
+
+    void Reset();
+
+    // False if the space was never built or overflowed FEmotionTagMask::NumBits, callers must fall back to tag containers
+    FORCEINLINE bool IsValid() const { return bIsValid; }
+
+    FORCEINLINE int32 Num() const { return Closures.Num(); }
+
+    // Bit index of a tag, or INDEX_NONE if the tag is not part of this space
+    FORCEINLINE int32 GetTagIndex(const FGameplayTag& Tag) const
+    {
+        const int32* Index = TagToIndex.Find(Tag);
+        return Index ? *Index : INDEX_NONE;
+    }
+
+    // Add a tag and all of its parents to the mask. Tags outside the space still contribute their known parents.
+    void AppendTag(FEmotionTagMask& Mask, const FGameplayTag& Tag) const;
+
+    // Build a hierarchical mask (tags plus parents) from a container
+    FEmotionTagMask MakeMask(const FGameplayTagContainer& Tags) const;
+
+    /**
+     * Build an exact query mask from a container (no parents)
+     * @param bOutComplete - False if some query tags are not part of this space and can therefore never match
+     */
+    FEmotionTagMask MakeQueryMask(const FGameplayTagContainer& Tags, bool& bOutComplete) const;
+
+    // Heap memory used by the space
+    SIZE_T GetAllocatedSize() const { return TagToIndex.GetAllocatedSize() + Closures.GetAllocatedSize(); }
+
+private:
+    TMap<FGameplayTag, int32> TagToIndex;
+    TArray<FEmotionTagMask> Closures;
+    bool bIsValid = false;
+};
+
+/**
+ * Query over a tag container that compiles itself lazily against the tag space of whatever it is matched with.
+ * Meant to be built once per query and tested against many agents sharing a few libraries.
+ */
+struct EMOTIONENGINE_API FEmotionTagQueryMask
+{
+    explicit FEmotionTagQueryMask(const FGameplayTagContainer& InTags)
+        : Tags(InTags)
+    {}
+
+    // Equivalent of AgentTags.HasAny(Tags)
+    bool MatchesAny(const FEmotionTagSpace& Space, const FEmotionTagMask& AgentMask) const;
+
+    // Equivalent of AgentTags.HasAll(Tags)
+    bool MatchesAll(const FEmotionTagSpace& Space, const FEmotionTagMask& AgentMask) const;
+
+    const FGameplayTagContainer& GetTags() const { return Tags; }
+
+private:
+    void CompileFor(const FEmotionTagSpace& Space) const;
+
+    const FGameplayTagContainer& Tags;
+    mutable const FEmotionTagSpace* CachedSpace = nullptr;
+    mutable FEmotionTagMask CachedMask;
+    mutable bool bCachedComplete = false;
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "EmotionTagMask.h"
+
+class UEmotionLibrary;
+
+/**
+ * Immutable emotion tag set shared by every agent that currently carries exactly these tags.
+ */
+struct EMOTIONENGINE_API FEmotionTagSet
+{
+    // The tags of the set, range and combined emotions included
+    FGameplayTagContainer Tags;
+
+    // Tags in the library's tag space, only meaningful if bHasMask is set
+    FEmotionTagMask Mask;
+
+    // Library whose tag space Mask was built in, identity only
+    const UEmotionLibrary* Library = nullptr;
+
+    // UEmotionLibrary::GetCompileId when the set was interned, the mask is stale once the library recompiles
+    uint32 LibraryCompileId = 0;
+
+    // Order independent hash of Library and Tags
+    uint32 Hash = 0;
+
+    // Number of FEmotionTagSetRef pointing at this set
+    int32 RefCount = 0;
+
+    // True if the library's tag space was valid when the set was interned
+    bool bHasMask = false;
+
+    // True if Mask is laid out in the library's current tag space
+    bool HasCurrentMask(const UEmotionLibrary* InLibrary) const;
+};
+
+/**
+ * Counted reference to an interned tag set, the set is recycled when the last reference goes away.
+ */
+struct EMOTIONENGINE_API FEmotionTagSetRef
+{
+    FEmotionTagSetRef() {}
+    FEmotionTagSetRef(const FEmotionTagSetRef& Other);
+    FEmotionTagSetRef(FEmotionTagSetRef&& Other);
+    FEmotionTagSetRef& operator=(const FEmotionTagSetRef& Other);
+    FEmotionTagSetRef& operator=(FEmotionTagSetRef&& Other);
+    ~FEmotionTagSetRef();
+
+    // Id of the set in FEmotionTagSetTable, equal ids mean equal tag sets
+    uint32 GetId() const { return Id; }
+
+    const FEmotionTagSet& Get() const;
+
+    // Drop the reference and point at the empty set
+    void Reset();
+
+    bool operator==(const FEmotionTagSetRef& Other) const { return Id == Other.Id; }
+
+private:
+    friend class FEmotionTagSetTable;
+
+    explicit FEmotionTagSetRef(uint32 InId) : Id(InId) {}
+
+    uint32 Id = 0;
+};
+
+/**
+ * Memory figures of the tag set table
+ */
+struct EMOTIONENGINE_API FEmotionTagSetStats
+{
+    // Distinct tag sets currently referenced
+    int32 NumSets = 0;
+
+    // References held by emotion states
+    int32 NumReferences = 0;
+
+    // Bytes used by the table, its sets and the references
+    SIZE_T InternedBytes = 0;
+
+    // Bytes the same tags would take if every reference owned its own container and mask
+    SIZE_T UninternedBytes = 0;
+
+    SIZE_T GetSavedBytes() const { return UninternedBytes > InternedBytes ? UninternedBytes - InternedBytes : 0; }
+};
+
+/**
+ * Hash-consing table for emotion tag sets. Agents in the same emotional situation share one immutable set by id,
+ * so tag set equality is an integer compare and queries can be answered once per set instead of once per agent.
+ * Shared by every world since emotion states have no world context, game thread only.
+ */
+class EMOTIONENGINE_API FEmotionTagSetTable
+{
+public:
+    // Id of the empty set, valid for every library and never recycled
+    static constexpr uint32 EmptySetId = 0;
+
+    static FEmotionTagSetTable& Get();
+
+    // Reference to the set holding exactly these tags for the library's current compilation, created if no agent carries it yet
+    FEmotionTagSetRef Intern(const UEmotionLibrary* Library, const FGameplayTagContainer& Tags);
+
+    const FEmotionTagSet& GetSet(uint32 Id) const;
+
+    FEmotionTagSetStats GetStats() const;
+
+private:
+    friend struct FEmotionTagSetRef;
+
+    FEmotionTagSetTable();
+
+    void AddRef(uint32 Id);
+    void Release(uint32 Id);
+
+    static uint32 HashTagSet(const UEmotionLibrary* Library, const FGameplayTagContainer& Tags);
+
+    // Indexed by id, sets are heap allocated so references to them stay valid while the table grows
+    TArray<TUniquePtr<FEmotionTagSet>> Sets;
+
+    // Ids of sets nobody references anymore
+    TArray<uint32> FreeIds;
+
+    // Hash -> ids of the sets with that hash
+    TMultiMap<uint32, uint32> IdsByHash;
+};
@@ -50,3 +50,93 @@ public:
     }
 
 };
+
+/**
+ * Zones of the core emotion wheel containing a VA coordinate, from the core emotion cone down to the variation.
+ * A level with no zone at the coordinate has an empty tag.
+ */
+USTRUCT(BlueprintType)
+struct EMOTIONENGINE_API FEmotionZonePath
+{
+    GENERATED_BODY()
+
+public:
+    // Core emotion whose cone contains the coordinate
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem", meta = (Categories = "Emotion"))
+    FGameplayTag CoreTag;
+
+    // Range of the core emotion containing the coordinate's radius
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem", meta = (Categories = "Emotion.Range"))
+    FGameplayTag RangeTag;
+
+    // Variation the coordinate leans toward inside the cone
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "EmotionSystem", meta = (Categories = "Emotion.Variation"))
+    FGameplayTag VariationTag;
+
+    FORCEINLINE bool operator==(const FEmotionZonePath& Other) const
+    {
+        return CoreTag == Other.CoreTag && RangeTag == Other.RangeTag && VariationTag == Other.VariationTag;
+    }
+};
+
+/**
+ * Zone hierarchy compiled into a lookup table. The wheel is cut into angular segments at every zone edge, and each
+ * segment into radius bands holding the zone path shared by every point of the band. Angles are compared as pseudo
+ * angles (monotonic in the true angle, no trigonometry) and bucketed, so a classification is a bucket read, a short
+ * scan of the edges inside the bucket and of the segment's bands, independent of the number of zones.
+ */
+struct EMOTIONENGINE_API FEmotionZoneTable
+{
+    // Buckets of the pseudo angle, each points at the first segment it overlaps
+    static constexpr int32 NumAngleBuckets = 256;
+
+    // Batches at least this large are classified in parallel
+    static constexpr int32 MinParallelBatchSize = 1024;
+
+    // Compile the zones of each level, the first zone of a level containing a point wins. Zone angle ranges are read
+    // counterclockwise from StartAngle to EndAngle so they can wrap past 0 degrees, spans of 360 degrees or more
+    // cover the whole wheel. The wheel has radius 1, points further out are classified at the rim.
+    void Build(TConstArrayView<FEmotionZone> CoreZones, TConstArrayView<FEmotionZone> RangeZones, TConstArrayView<FEmotionZone> VariationZones);
+
+    void Reset();
+
+    // Zone path of a VA coordinate
+    FEmotionZonePath Classify(const FVector2D& Coordinate) const;
+
+    // Zone paths of many VA coordinates, OutPaths must be as large as Coordinates
+    void ClassifyBatch(TConstArrayView<FVector2D> Coordinates, TArrayView<FEmotionZonePath> OutPaths) const;
+
+    FORCEINLINE bool IsEmpty() const { return Segments.Num() == 0; }
+
+    // Heap memory used by the table
+    SIZE_T GetAllocatedSize() const;
+
+    // Stand-in for the angle of a direction in [0, 4), a quarter turn per unit, ordered like the angle
+    static float GetPseudoAngle(const FVector2D& Direction);
+
+    // Pseudo angle of an angle in degrees
+    static float DegreesToPseudoAngle(float Degrees);
+
+private:
+    // Points up to MaxRadiusSquared (and beyond the previous band) share the path
+    struct FBand
+    {
+        float MaxRadiusSquared = 0.0f;
+        FEmotionZonePath Path;
+    };
+
+    // Pseudo angles from the previous segment's end up to EndPseudoAngle, bands sorted by radius
+    struct FSegment
+    {
+        float EndPseudoAngle = 0.0f;
+        int32 FirstBand = 0;
+        int32 NumBands = 0;
+    };
+
+    // Sorted by angle, the last one ends at 4
+    TArray<FSegment> Segments;
+    TArray<FBand> Bands;
+
+    // Index of the segment containing the start of each bucket
+    TArray<int32> BucketSegments;
+};
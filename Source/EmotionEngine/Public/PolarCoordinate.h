@@ -68,6 +68,33 @@ public:
      FORCEINLINE float GetStrengthForCartesianCoordinate(const FVector2D& Coordinate) const;
  };
 
+/**
+ * Polar coordinate conversions over arrays, structure of arrays, four values per VectorRegister.
+ * Angles are in degrees like UPolarCoordinateLibrary, the outputs may alias the inputs they replace.
+ * Error bounds are against the scalar functions and checked by the EmotionEngine.PolarCoordinate.BatchErrorBounds test.
+ */
+struct EMOTIONENGINE_API FPolarCoordinateBatch
+{
+    // Largest difference of a Cartesian component from PolarToCartesian, per unit of intensity
+    static constexpr float MaxCartesianError = 1.0e-6f;
+
+    // Largest difference of an angle from CartesianToPolar in degrees, around the circle
+    static constexpr float MaxAngleError = 2.0e-4f;
+
+    // Largest relative difference of an intensity from CartesianToPolar
+    static constexpr float MaxIntensityRelativeError = 1.0e-6f;
+
+    // NormalizeAngle of every angle, exact for angles within 1e8 degrees. A negative angle whose scalar result rounds up to 360 returns 0.
+    static void NormalizeAngles(TConstArrayView<float> Angles, TArrayView<float> OutAngles);
+
+    // PolarToCartesian(MakePolarCoordinate) of every angle and intensity, negative intensities map to the origin.
+    // Angles are normalized first, so the error does not grow with their magnitude.
+    static void PolarToCartesian(TConstArrayView<float> Angles, TConstArrayView<float> Intensities, TArrayView<float> OutX, TArrayView<float> OutY);
+
+    // CartesianToPolar of every coordinate, angles in [0, 360) and 0 below SMALL_NUMBER intensity
+    static void CartesianToPolar(TConstArrayView<float> X, TConstArrayView<float> Y, TArrayView<float> OutAngles, TArrayView<float> OutIntensities);
+};
+
 /**
  * Blueprint function library for working with polar coordinates and ranges
  */